@@ -0,0 +1,403 @@
+#!/usr/bin/env python3
+"""Runs the C++ and Rust solutions of each day side by side on generated inputs.
+
+For every day and scale a puzzle input is generated, both implementations are built and run on
+it, and the answers, best wall time and peak RSS are reported next to each other. Scale 1 is
+about the size of a real puzzle input; scale k makes it roughly k times larger.
+
+Peak RSS is taken by bench/maxrss.c, which the script builds with CC; the first row runs `true`
+through it to show the floor, about 1 MB.
+
+Per-phase numbers are read from stderr lines of the form "<phase>: <ms> ms, ...". The C++
+solutions print them through aoc::Phase when built with AOC_TRACK_ALLOCATIONS, so they come
+from a separate tracking build and are not mixed into the timed runs. A Rust solution that
+prints the same lines gets the same treatment.
+
+The Rust solutions embed puzzle.txt with include_str!, so they are rebuilt for every input in
+a scratch cargo project. Crates they use must be in the local cargo cache, since the build
+runs offline.
+
+    bench/bench.py                      # every day at scales 1, 2 and 4
+    bench/bench.py --days 3 8 --scales 1 10 --repeat 5
+
+CXX, CXXFLAGS and LDFLAGS are taken from the environment.
+"""
+
+import argparse
+import os
+import random
+import re
+import shlex
+import shutil
+import signal
+import string
+import subprocess
+import sys
+import tempfile
+import time
+from pathlib import Path
+
+ROOT = Path(__file__).resolve().parent.parent
+
+# Crates the Rust solutions use, pinned to the versions they were written against.
+CRATES = {"itertools": '"0.14"', "z3": '"0.12"'}
+
+
+# Input generators. Each takes a seeded Random and a scale and returns the text of a puzzle
+# input in that day's format.
+
+
+def day1(rng, scale):
+    turns = (f"{rng.choice('LR')}{rng.randint(1, 999)}" for _ in range(4000 * scale))
+    return "\n".join(turns) + "\n"
+
+
+def day2(rng, scale):
+    ranges = []
+    start = 10
+    for _ in range(30 * scale):
+        start += rng.randint(1, 10 ** rng.randint(1, 9))
+        end = start + rng.randint(0, 100000)
+        ranges.append(f"{start}-{end}")
+        start = end + 1
+    rng.shuffle(ranges)
+    return ",".join(ranges) + "\n"
+
+
+def day3(rng, scale):
+    lines = ("".join(rng.choice("123456789") for _ in range(100)) for _ in range(200 * scale))
+    return "\n".join(lines) + "\n"
+
+
+def day4(rng, scale):
+    side = int(140 * scale**0.5)
+    lines = ("".join("@" if rng.random() < 0.6 else "." for _ in range(side)) for _ in range(side))
+    return "\n".join(lines) + "\n"
+
+
+def day5(rng, scale):
+    ranges = []
+    for _ in range(180 * scale):
+        start = rng.randint(1, 10**15)
+        ranges.append(f"{start}-{start + rng.randint(0, 10**13)}")
+    ids = (str(rng.randint(1, 10**15)) for _ in range(1000 * scale))
+    return "\n".join(ranges) + "\n\n" + "\n".join(ids) + "\n"
+
+
+def day6(rng, scale):
+    rows = 4
+    columns = [[] for _ in range(rows + 1)]
+    for _ in range(1000 * scale):
+        # As in real inputs, the widest number fills the problem's columns, since a blank column
+        # reads as the gap between two problems, and the lengths are sorted so that no digit
+        # column has a space between two digits.
+        width = rng.randint(1, 4)
+        right = rng.random() < 0.5
+        lengths = sorted([width] + [rng.randint(1, width) for _ in range(rows - 1)],
+                         reverse=rng.random() < 0.5)
+        for row, digits in enumerate(lengths):
+            number = str(rng.randint(10 ** (digits - 1), 10**digits - 1))
+            columns[row].append(number.rjust(width) if right else number.ljust(width))
+        columns[rows].append(rng.choice("+*").ljust(width))
+    return "\n".join(" ".join(cells) for cells in columns) + "\n"
+
+
+def day7(rng, scale):
+    width = 141
+    lines = ["." * (width // 2) + "S" + "." * (width // 2)]
+    for row in range(1, 71 * scale):
+        line = ["."] * width
+        if row % 2 == 0:
+            for column in range(1, width - 1):
+                if rng.random() < 0.1:
+                    line[column] = "^"
+        lines.append("".join(line))
+    return "\n".join(lines) + "\n"
+
+
+def day8(rng, scale):
+    boxes = (
+        ",".join(str(rng.randint(0, 99999)) for _ in range(3)) for _ in range(1000 * scale)
+    )
+    return "\n".join(boxes) + "\n"
+
+
+def day9(rng, scale):
+    # A rectilinear polygon over a staircase of columns, so consecutive red tiles always share a
+    # row or a column and the boundary never crosses itself.
+    columns = 250 * scale
+    xs = sorted(rng.sample(range(1, 100000 * scale), columns + 1))
+    heights = []
+    for _ in range(columns):
+        height = rng.randint(1, 100000)
+        while heights and height == heights[-1]:
+            height = rng.randint(1, 100000)
+        heights.append(height)
+    points = [(xs[0], 0)]
+    for i, height in enumerate(heights):
+        points += [(xs[i], height), (xs[i + 1], height)]
+    points.append((xs[-1], 0))
+    return "\n".join(f"{x},{y}" for x, y in points) + "\n"
+
+
+def day10(rng, scale):
+    machines = []
+    for _ in range(190 * scale):
+        lights = rng.randint(4, 10)
+        buttons = [
+            sorted(rng.sample(range(lights), rng.randint(1, lights)))
+            for _ in range(rng.randint(lights - 2, lights + 3))
+        ]
+        presses = [rng.randint(0, 20) for _ in buttons]
+        toggles = [rng.randint(0, 1) for _ in buttons]
+        joltage = [0] * lights
+        pattern = [0] * lights
+        for button, count, toggle in zip(buttons, presses, toggles):
+            for light in button:
+                joltage[light] += count
+                pattern[light] ^= toggle
+        machines.append(
+            "[" + "".join(".#"[on] for on in pattern) + "] "
+            + " ".join("(" + ",".join(map(str, button)) + ")" for button in buttons)
+            + " {" + ",".join(map(str, joltage)) + "}"
+        )
+    return "\n".join(machines) + "\n"
+
+
+def day11(rng, scale):
+    # A layered DAG: every device feeds one to three devices in the next two layers and the
+    # last layer feeds "out". "svr" starts it, "dac" and "fft" sit in the middle and "you" near
+    # the end, so both answers are nonzero and stay far from overflowing.
+    layers, width = 24, 27 * scale
+    letters = 3 if layers * width < 15000 else 4
+    reserved = {"svr", "dac", "fft", "you", "out"}
+    names = set()
+    while len(names) < layers * width:
+        name = "".join(rng.choices(string.ascii_lowercase, k=letters))
+        if name not in reserved:
+            names.add(name)
+    names = sorted(names)
+    rng.shuffle(names)
+    grid = [names[i * width:(i + 1) * width] for i in range(layers)]
+    grid[0][0], grid[8][0], grid[14][0], grid[layers - 4][0] = "svr", "dac", "fft", "you"
+    lines = []
+    for i, layer in enumerate(grid):
+        for name in layer:
+            if i == layers - 1:
+                outputs = ["out"]
+            else:
+                below = grid[i + 1] + (grid[i + 2] if i + 2 < layers else [])
+                outputs = rng.sample(below, rng.randint(1, 3))
+                if name in ("svr", "dac") or grid[i + 1][0] in ("dac", "fft", "you"):
+                    if grid[i + 1][0] not in outputs:
+                        outputs[0] = grid[i + 1][0]
+            lines.append(f"{name}: {' '.join(outputs)}")
+    rng.shuffle(lines)
+    return "\n".join(lines) + "\n"
+
+
+GENERATORS = {n: globals()[f"day{n}"] for n in range(1, 12)}
+
+
+class Result:
+    def __init__(self, error=None, answers=(), seconds=None, rss_kb=None, phases=None):
+        self.error = error
+        self.answers = answers
+        self.seconds = seconds
+        self.rss_kb = rss_kb
+        self.phases = phases or {}
+
+
+def run(binary, cwd, timeout, maxrss):
+    """Runs binary once in cwd; returns stdout, stderr, wall seconds and peak RSS in KB.
+
+    The binary is started through the maxrss helper, so the peak is the binary's own rather
+    than this interpreter's, which a child forked from here would inherit.
+    """
+    (cwd / "puzzle.txt.snapshot").unlink(missing_ok=True)
+    with tempfile.TemporaryFile() as out, tempfile.TemporaryFile() as err, \
+            tempfile.NamedTemporaryFile() as rss:
+        command = [str(maxrss), rss.name, str(binary)]
+        start = time.perf_counter()
+        process = subprocess.Popen(command, cwd=cwd, stdout=out, stderr=err,
+                                   start_new_session=True)
+        try:
+            process.wait(timeout)
+        except subprocess.TimeoutExpired:
+            os.killpg(process.pid, signal.SIGKILL)
+            process.wait()
+            raise TimeoutError
+        seconds = time.perf_counter() - start
+        out.seek(0)
+        err.seek(0)
+        stdout, stderr = out.read().decode(), err.read().decode()
+        peak = rss.read().decode().strip()
+    if process.returncode != 0:
+        lines = [line for line in stderr.splitlines() if line.strip() and "panicked" not in line]
+        raise RuntimeError(f"exit {process.returncode}: {(lines or [''])[0][:120]}")
+    return stdout, stderr, seconds, int(peak)
+
+
+def answers(stdout):
+    """The last integer on each output line, ignoring labels such as "Part 1:"."""
+    return tuple(m[-1] for m in (re.findall(r"-?\d+", line) for line in stdout.splitlines()) if m)
+
+
+def phases(stderr):
+    return {m[1]: float(m[2]) for m in re.finditer(r"^(\w+): ([\d.]+) ms", stderr, re.M)}
+
+
+def measure(binary, cwd, repeat, timeout, maxrss, tracking=None):
+    if isinstance(binary, str):
+        return Result(error=binary)
+    try:
+        best = None
+        for _ in range(max(repeat, 1)):
+            stdout, stderr, seconds, rss = run(binary, cwd, timeout, maxrss)
+            if best is None or seconds < best.seconds:
+                best = Result(answers=answers(stdout), seconds=seconds, rss_kb=rss,
+                              phases=phases(stderr))
+        if tracking and not isinstance(tracking, str):
+            best.phases = phases(run(tracking, cwd, timeout, maxrss)[1])
+        return best
+    except TimeoutError:
+        return Result(error="timeout")
+    except RuntimeError as error:
+        return Result(error=str(error))
+
+
+def build_cpp(day, out, defines=()):
+    """Builds dayN/main.cpp once; it reads puzzle.txt from the working directory."""
+    cxx = os.environ.get("CXX", "g++")
+    flags = shlex.split(os.environ.get("CXXFLAGS", "-std=c++23 -O2"))
+    libraries = ["-pthread", *shlex.split(os.environ.get("LDFLAGS", ""))]
+    if "-DWITH_Z3" in flags:
+        libraries.append("-lz3")
+    command = [cxx, *flags, *defines, str(ROOT / f"day{day}" / "main.cpp"), "-o", str(out)]
+    built = subprocess.run(command + libraries, capture_output=True, text=True)
+    if built.returncode != 0:
+        return "C++ build failed: " + (built.stderr.strip().splitlines() or ["?"])[0][:120]
+    return out
+
+
+def build_maxrss(out):
+    """Builds the helper that reports a command's own peak RSS, see maxrss.c."""
+    cc = os.environ.get("CC", "cc")
+    command = [cc, "-O2", str(ROOT / "bench" / "maxrss.c"), "-o", str(out)]
+    subprocess.run(command, check=True)
+    return out
+
+
+def build_rust(day, project, target):
+    """Builds the day's src/main.rs against project/puzzle.txt, which it embeds."""
+    source = (ROOT / f"day{day}" / "src" / "main.rs").read_text()
+    crates = sorted(c for c in CRATES if re.search(rf"\b(use|extern crate) {c}\b", source))
+    (project / "src").mkdir(parents=True, exist_ok=True)
+    (project / "src" / "main.rs").write_text(source)
+    manifest = [
+        "[package]",
+        f'name = "day{day}"',
+        'version = "0.1.0"',
+        'edition = "2021"',
+        "",
+        "[dependencies]",
+        *(f"{crate} = {CRATES[crate]}" for crate in crates),
+        "",
+        "[profile.release]",
+        "debug = false",
+    ]
+    (project / "Cargo.toml").write_text("\n".join(manifest) + "\n")
+    command = ["cargo", "build", "--release", "--offline", "--quiet"]
+    if "#![feature" in source:
+        command.insert(1, "+nightly")
+    env = dict(os.environ, CARGO_TARGET_DIR=str(target))
+    built = subprocess.run(command, cwd=project, env=env, capture_output=True, text=True)
+    if built.returncode != 0:
+        lines = [line for line in built.stderr.splitlines() if line.strip()]
+        return "Rust build failed: " + (lines[0] if lines else "?")[:120]
+    return target / "release" / f"day{day}"
+
+
+def cell(result, value):
+    return result.error and "-" or value(result)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--days", type=int, nargs="+", default=list(GENERATORS))
+    parser.add_argument("--scales", type=int, nargs="+", default=[1, 2, 4])
+    parser.add_argument("--repeat", type=int, default=3, help="runs per binary; best is kept")
+    parser.add_argument("--timeout", type=float, default=60, help="seconds per run")
+    parser.add_argument("--seed", type=int, default=2025)
+    parser.add_argument("--keep", action="store_true", help="keep the scratch directory")
+    args = parser.parse_args()
+
+    scratch = Path(tempfile.mkdtemp(prefix="aoc-bench-"))
+    maxrss = build_maxrss(scratch / "maxrss")
+    header = (
+        f"{'day':>5} {'scale':>5} {'input':>9} | {'C++ ms':>9} {'Rust ms':>9} | "
+        f"{'C++ MB':>7} {'Rust MB':>7} | answers"
+    )
+    print(header)
+    print("-" * len(header))
+    # A trivial binary, to show what the RSS column reads for a process that does nothing.
+    true = measure(Path(shutil.which("true")), scratch, args.repeat, args.timeout, maxrss)
+    print(
+        f"{'true':>5} {'-':>5} {'-':>9} | {cell(true, lambda x: f'{x.seconds * 1e3:.2f}'):>9} "
+        f"{'-':>9} | {cell(true, lambda x: f'{x.rss_kb / 1024:.1f}'):>7} {'-':>7} | "
+        f"{true.error or 'baseline'}",
+        flush=True,
+    )
+    notes = []
+    disagreements = 0
+    try:
+        for day in args.days:
+            cpp = build_cpp(day, scratch / f"day{day}-cpp")
+            tracking = build_cpp(
+                day, scratch / f"day{day}-cpp-tracking", ["-DAOC_TRACK_ALLOCATIONS"]
+            )
+            for scale in args.scales:
+                rng = random.Random(f"{args.seed}/{day}/{scale}")
+                work = scratch / f"day{day}-x{scale}"
+                work.mkdir()
+                text = GENERATORS[day](rng, scale)
+                (work / "puzzle.txt").write_text(text)
+                (work / "rust").mkdir()
+                shutil.copy(work / "puzzle.txt", work / "rust" / "puzzle.txt")
+                rust = build_rust(day, work / "rust", scratch / f"day{day}-target")
+
+                c = measure(cpp, work, args.repeat, args.timeout, maxrss, tracking)
+                r = measure(rust, work, args.repeat, args.timeout, maxrss)
+                if c.error or r.error:
+                    verdict = "; ".join(f"{side}: {x.error}" for side, x in
+                                        (("C++", c), ("Rust", r)) if x.error)
+                elif c.answers == r.answers:
+                    verdict = "agree " + " ".join(c.answers)
+                else:
+                    verdict = f"DIFFER C++ {' '.join(c.answers)} / Rust {' '.join(r.answers)}"
+                    disagreements += 1
+                print(
+                    f"{day:>5} {scale:>5} {len(text) / 1024:>7.0f}KB | "
+                    f"{cell(c, lambda x: f'{x.seconds * 1e3:.2f}'):>9} "
+                    f"{cell(r, lambda x: f'{x.seconds * 1e3:.2f}'):>9} | "
+                    f"{cell(c, lambda x: f'{x.rss_kb / 1024:.1f}'):>7} "
+                    f"{cell(r, lambda x: f'{x.rss_kb / 1024:.1f}'):>7} | {verdict}",
+                    flush=True,
+                )
+                for side, result in (("C++", c), ("Rust", r)):
+                    if result.phases:
+                        listed = ", ".join(f"{k} {v:.2f} ms" for k, v in result.phases.items())
+                        notes.append(f"day{day} x{scale} {side} phases: {listed}")
+    finally:
+        if args.keep:
+            print(f"\nscratch directory: {scratch}")
+        else:
+            shutil.rmtree(scratch, ignore_errors=True)
+    if notes:
+        print()
+        print("\n".join(notes))
+    return 1 if disagreements else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
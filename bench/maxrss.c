@@ -0,0 +1,45 @@
+// Runs a command and writes its peak RSS in KB to the file named by the first argument.
+//
+//     maxrss <out> <command> [args...]
+//
+// A process forked straight from Python reports the interpreter's RSS high-water mark as its
+// own, since exec keeps the larger of the old and new peaks. This helper is small, so the
+// command it forks and execs starts from its footprint instead.
+
+#include <stdio.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        fprintf(stderr, "usage: maxrss <out> <command> [args...]\n");
+        return 2;
+    }
+    pid_t pid = fork();
+    if (pid < 0) {
+        perror("fork");
+        return 2;
+    }
+    if (pid == 0) {
+        execvp(argv[2], argv + 2);
+        perror(argv[2]);
+        _exit(127);
+    }
+    int status;
+    struct rusage usage;
+    if (wait4(pid, &status, 0, &usage) < 0) {
+        perror("wait4");
+        return 2;
+    }
+    FILE* out = fopen(argv[1], "w");
+    if (!out) {
+        perror(argv[1]);
+        return 2;
+    }
+    fprintf(out, "%ld\n", usage.ru_maxrss);
+    fclose(out);
+    if (WIFSIGNALED(status))
+        return 128 + WTERMSIG(status);
+    return WEXITSTATUS(status);
+}
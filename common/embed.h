@@ -0,0 +1,25 @@
+#pragma once
+
+#include <string_view>
+
+// The puzzle input built into the program, for days that solve it while compiling. Before
+// including this header a day defines AOC_EMBED_FILE as the path of its puzzle.txt and
+// AOC_EMBED_XXD as the path of the `xxd -i` dump of it, both relative to this directory. The
+// dump is only read by compilers without #embed.
+#if !defined(AOC_EMBED_FILE) || !defined(AOC_EMBED_XXD)
+#error "define AOC_EMBED_FILE and AOC_EMBED_XXD before including embed.h"
+#endif
+
+namespace aoc {
+
+inline constexpr char embedded_bytes[] = {
+#if defined(__has_embed)
+#embed AOC_EMBED_FILE
+#else
+#include AOC_EMBED_XXD
+#endif
+};
+
+inline constexpr std::string_view embedded_input{embedded_bytes, sizeof(embedded_bytes)};
+
+}  // namespace aoc
@@ -0,0 +1,210 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <iomanip>
+#include <iostream>
+#include <memory_resource>
+#include <new>
+#include <string>
+#include <string_view>
+
+// Allocation accounting for the day solutions. Solutions allocate their working data from a
+// per-run Arena, and Phase scopes report how much each part asked for, both from the arena and
+// from the global heap, so steady-state code can be checked to allocate nothing.
+namespace aoc {
+
+struct AllocationStats {
+    size_t allocations = 0;
+    size_t bytes = 0;
+
+    AllocationStats operator-(AllocationStats const& other) const {
+        return {allocations - other.allocations, bytes - other.bytes};
+    }
+};
+
+// Global operator new traffic. Only counted in a program that defines AOC_TRACK_ALLOCATIONS
+// before including this header, which replaces the global operator new and delete; that must
+// happen in exactly one translation unit.
+inline std::atomic<size_t> heap_allocations{0};
+inline std::atomic<size_t> heap_bytes{0};
+
+inline AllocationStats heap_stats() {
+    return {heap_allocations.load(std::memory_order_relaxed),
+            heap_bytes.load(std::memory_order_relaxed)};
+}
+
+// Counts every request that passes through it and forwards it to `upstream`.
+class TrackingResource : public std::pmr::memory_resource {
+   public:
+    explicit TrackingResource(
+        std::pmr::memory_resource* upstream = std::pmr::new_delete_resource())
+        : upstream(upstream) {}
+
+    AllocationStats stats() const { return counted; }
+
+   private:
+    void* do_allocate(size_t bytes, size_t alignment) override {
+        counted.allocations++;
+        counted.bytes += bytes;
+        return upstream->allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void* p, size_t bytes, size_t alignment) override {
+        upstream->deallocate(p, bytes, alignment);
+    }
+
+    bool do_is_equal(std::pmr::memory_resource const& other) const noexcept override {
+        return this == &other;
+    }
+
+    std::pmr::memory_resource* upstream;
+    AllocationStats counted;
+};
+
+// Monotonic arena for one run: allocations are pointer bumps and nothing is returned until the
+// arena itself goes away. Requests made of the arena and the heap blocks it grows by are
+// counted separately. Not thread-safe; allocate from one thread.
+class Arena {
+   public:
+    explicit Arena(size_t initial_size = size_t{1} << 20)
+        : buffer(initial_size, &heap), requests(&buffer) {}
+
+    Arena(Arena const&) = delete;
+    Arena& operator=(Arena const&) = delete;
+
+    std::pmr::memory_resource* resource() { return &requests; }
+
+    AllocationStats requested() const { return requests.stats(); }
+
+    AllocationStats reserved() const { return heap.stats(); }
+
+   private:
+    TrackingResource heap;
+    std::pmr::monotonic_buffer_resource buffer;
+    TrackingResource requests;
+};
+
+// Writes the time taken and the allocations made while it is alive to stderr, one line per phase
+// such as "part1: 1.250 ms, 0 heap allocations (0 bytes)", in programs built with
+// AOC_TRACK_ALLOCATIONS. With an arena, the blocks it grew by are reported on their own and left
+// out of the heap count.
+class Phase {
+   public:
+    explicit Phase(std::string_view name)
+        : name(name), heap_start(heap_stats()), start(std::chrono::steady_clock::now()) {}
+
+    Phase(std::string_view name, Arena& arena)
+        : name(name),
+          arena(&arena),
+          arena_start(arena.requested()),
+          reserved_start(arena.reserved()),
+          heap_start(heap_stats()),
+          start(std::chrono::steady_clock::now()) {}
+
+    Phase(Phase const&) = delete;
+    Phase& operator=(Phase const&) = delete;
+
+    ~Phase() {
+#ifdef AOC_TRACK_ALLOCATIONS
+        std::chrono::duration<double, std::milli> elapsed =
+            std::chrono::steady_clock::now() - start;
+        auto from_heap = heap_stats() - heap_start;
+        std::cerr << name << ": " << std::fixed << std::setprecision(3) << elapsed.count()
+                  << " ms, ";
+        if (arena) {
+            auto from_arena = arena->requested() - arena_start;
+            auto reserved = arena->reserved() - reserved_start;
+            from_heap = from_heap - reserved;
+            std::cerr << from_arena.allocations << " arena allocations (" << from_arena.bytes
+                      << " bytes), " << reserved.allocations << " arena blocks ("
+                      << reserved.bytes << " bytes), ";
+        }
+        std::cerr << from_heap.allocations << " heap allocations (" << from_heap.bytes
+                  << " bytes)\n";
+#endif
+    }
+
+   private:
+    std::string name;
+    Arena* arena = nullptr;
+    AllocationStats arena_start;
+    AllocationStats reserved_start;
+    AllocationStats heap_start;
+    std::chrono::steady_clock::time_point start;
+};
+
+}  // namespace aoc
+
+#ifdef AOC_TRACK_ALLOCATIONS
+#include <cstdlib>
+
+// Every form of operator new and delete goes through this one pair, so each allocation is
+// counted once and freed by the function that matches how it was made. They stay out of line
+// so the compiler does not pair a new-expression with free().
+namespace aoc {
+
+[[gnu::noinline]] inline void* heap_allocate(size_t size, size_t alignment) noexcept {
+    heap_allocations.fetch_add(1, std::memory_order_relaxed);
+    heap_bytes.fetch_add(size, std::memory_order_relaxed);
+    size = size == 0 ? 1 : size;
+    if (alignment <= __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+        return std::malloc(size);
+    }
+    return std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+}
+
+[[gnu::noinline]] inline void heap_release(void* p) noexcept { std::free(p); }
+
+inline void* heap_allocate_or_throw(size_t size, size_t alignment) {
+    if (void* p = heap_allocate(size, alignment)) {
+        return p;
+    }
+    throw std::bad_alloc{};
+}
+
+}  // namespace aoc
+
+void* operator new(size_t size) {
+    return aoc::heap_allocate_or_throw(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+}
+void* operator new[](size_t size) {
+    return aoc::heap_allocate_or_throw(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+}
+void* operator new(size_t size, std::align_val_t alignment) {
+    return aoc::heap_allocate_or_throw(size, static_cast<size_t>(alignment));
+}
+void* operator new[](size_t size, std::align_val_t alignment) {
+    return aoc::heap_allocate_or_throw(size, static_cast<size_t>(alignment));
+}
+void* operator new(size_t size, std::nothrow_t const&) noexcept {
+    return aoc::heap_allocate(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+}
+void* operator new[](size_t size, std::nothrow_t const&) noexcept {
+    return aoc::heap_allocate(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+}
+void* operator new(size_t size, std::align_val_t alignment, std::nothrow_t const&) noexcept {
+    return aoc::heap_allocate(size, static_cast<size_t>(alignment));
+}
+void* operator new[](size_t size, std::align_val_t alignment, std::nothrow_t const&) noexcept {
+    return aoc::heap_allocate(size, static_cast<size_t>(alignment));
+}
+
+void operator delete(void* p) noexcept { aoc::heap_release(p); }
+void operator delete[](void* p) noexcept { aoc::heap_release(p); }
+void operator delete(void* p, size_t) noexcept { aoc::heap_release(p); }
+void operator delete[](void* p, size_t) noexcept { aoc::heap_release(p); }
+void operator delete(void* p, std::align_val_t) noexcept { aoc::heap_release(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { aoc::heap_release(p); }
+void operator delete(void* p, size_t, std::align_val_t) noexcept { aoc::heap_release(p); }
+void operator delete[](void* p, size_t, std::align_val_t) noexcept { aoc::heap_release(p); }
+void operator delete(void* p, std::nothrow_t const&) noexcept { aoc::heap_release(p); }
+void operator delete[](void* p, std::nothrow_t const&) noexcept { aoc::heap_release(p); }
+void operator delete(void* p, std::align_val_t, std::nothrow_t const&) noexcept {
+    aoc::heap_release(p);
+}
+void operator delete[](void* p, std::align_val_t, std::nothrow_t const&) noexcept {
+    aoc::heap_release(p);
+}
+#endif
@@ -0,0 +1,177 @@
+#pragma once
+
+#include <bit>
+#include <charconv>
+#include <concepts>
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+// Allocation-free parsing shared by the day solutions: read the input once, then walk it with a
+// Scanner that converts fields in place instead of building substrings for stoi and friends.
+namespace aoc {
+
+// Whole remaining contents of a stream, read with a single allocation.
+inline std::string read_all(std::istream& input) {
+    std::string text;
+    input.seekg(0, std::ios::end);
+    if (auto size = input.tellg(); size > 0) {
+        text.resize(static_cast<size_t>(size));
+        input.seekg(0, std::ios::beg);
+        input.read(text.data(), size);
+        text.resize(static_cast<size_t>(input.gcount()));
+    }
+    return text;
+}
+
+// Value of the eight ASCII digits at p, or -1 if any of them is not a digit. The bytes are
+// loaded as one little-endian word, checked together and then folded pairwise in three
+// multiply-shift steps (SIMD within a register), instead of eight dependent multiply-adds.
+inline int64_t eight_digits(char const* p) {
+    static_assert(std::endian::native == std::endian::little);
+    uint64_t chunk;
+    std::memcpy(&chunk, p, sizeof(chunk));
+    if ((((chunk & 0xF0F0F0F0F0F0F0F0) |
+          (((chunk + 0x0606060606060606) & 0xF0F0F0F0F0F0F0F0) >> 4)) != 0x3333333333333333)) {
+        return -1;
+    }
+    chunk -= 0x3030303030303030;
+    chunk = (chunk * 10 + (chunk >> 8)) & 0x00FF00FF00FF00FF;
+    chunk = (chunk * 100 + (chunk >> 16)) & 0x0000FFFF0000FFFF;
+    chunk = (chunk * 10000 + (chunk >> 32)) & 0x00000000FFFFFFFF;
+    return static_cast<int64_t>(chunk);
+}
+
+// Cursor over a text buffer. Fields are pulled off the front with the typed accessors; the
+// buffer must outlive any string_view handed out. Everything is constexpr so that inputs embedded
+// in the binary can be parsed during compilation.
+class Scanner {
+   public:
+    constexpr explicit Scanner(std::string_view text)
+        : pos(text.data()), end(text.data() + text.size()) {}
+
+    constexpr bool done() const { return pos == end; }
+
+    constexpr char peek() const { return pos == end ? '\0' : *pos; }
+
+    constexpr char next() {
+        if (pos == end) {
+            throw std::runtime_error("unexpected end of input");
+        }
+        return *pos++;
+    }
+
+    constexpr bool consume(char c) {
+        if (peek() != c) {
+            return false;
+        }
+        ++pos;
+        return true;
+    }
+
+    constexpr void expect(char c) {
+        if (!consume(c)) {
+            throw std::runtime_error(std::string("expected '") + c + "'");
+        }
+    }
+
+    constexpr void skip(char c) {
+        while (pos != end && *pos == c) {
+            ++pos;
+        }
+    }
+
+    // Text up to, but not including, the next `delimiter` or the end of the buffer.
+    constexpr std::string_view until(char delimiter) {
+        char const* start = pos;
+        char const* found = std::char_traits<char>::find(pos, end - pos, delimiter);
+        pos = found ? found : end;
+        return {start, pos};
+    }
+
+    // The rest of the current line, consuming the newline and dropping any carriage return.
+    constexpr std::string_view line() {
+        std::string_view text = until('\n');
+        consume('\n');
+        if (text.ends_with('\r')) {
+            text.remove_suffix(1);
+        }
+        return text;
+    }
+
+    // Integer at the cursor. Unsigned digit runs of eight or more are folded eight at a time;
+    // everything else, including signs and values too long for T, goes through from_chars.
+    template <std::integral T>
+    constexpr T number() {
+        if consteval {
+            return plain_number<T>();
+        }
+        constexpr int max_digits = std::numeric_limits<T>::digits10;
+        if (end - pos >= 8 && max_digits >= 8) {
+            char const* start = pos;
+            uint64_t value = 0;
+            int digits = 0;
+            for (int64_t chunk; end - pos >= 8 && digits + 8 <= max_digits &&
+                                (chunk = eight_digits(pos)) >= 0;
+                 pos += 8, digits += 8) {
+                value = value * 100000000 + static_cast<uint64_t>(chunk);
+            }
+            for (; pos != end && is_digit(*pos) && digits < max_digits; ++pos, ++digits) {
+                value = value * 10 + static_cast<uint64_t>(*pos - '0');
+            }
+            if (digits > 0 && (pos == end || !is_digit(*pos))) {
+                return static_cast<T>(value);
+            }
+            pos = start;
+        }
+
+        T value{};
+        auto [next, error] = std::from_chars(pos, end, value);
+        if (error != std::errc{}) {
+            throw std::runtime_error("malformed number");
+        }
+        pos = next;
+        return value;
+    }
+
+   private:
+    static constexpr bool is_digit(char c) { return c >= '0' && c <= '9'; }
+
+    // Digit-at-a-time conversion for constant evaluation, where neither the word loads nor
+    // from_chars are available.
+    template <std::integral T>
+    constexpr T plain_number() {
+        const bool negative = std::is_signed_v<T> && consume('-');
+        if (pos == end || !is_digit(*pos)) {
+            throw std::runtime_error("malformed number");
+        }
+        T value{};
+        for (; pos != end && is_digit(*pos); ++pos) {
+            value = static_cast<T>(value * 10 + (*pos - '0'));
+        }
+        return negative ? static_cast<T>(-value) : value;
+    }
+
+    char const* pos;
+    char const* end;
+};
+
+// Every integer in a `delimiter` separated list such as "3,1,4".
+template <std::integral T>
+std::vector<T> numbers(std::string_view text, char delimiter = ',') {
+    std::vector<T> result;
+    Scanner scanner{text};
+    while (!scanner.done()) {
+        result.push_back(scanner.number<T>());
+        scanner.consume(delimiter);
+    }
+    return result;
+}
+
+}  // namespace aoc
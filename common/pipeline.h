@@ -0,0 +1,216 @@
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <istream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Overlapped input and compute for inputs made of independent line records. A reader thread
+// pulls the input in blocks cut at line ends and parses each block, worker threads solve the
+// blocks already parsed, and the calling thread merges the per-block results in input order as
+// they become available. Queues between the stages are bounded, so a slow stage stalls the one
+// feeding it instead of letting parsed input pile up.
+namespace aoc {
+
+struct PipelineOptions {
+    // Bytes read per block; a block is extended to the next line end.
+    size_t block_size = size_t{1} << 16;
+    // Parsed blocks waiting for a worker before the reader blocks.
+    size_t max_pending = 16;
+    // Worker threads; 0 means one per hardware thread, less the reader.
+    unsigned workers = 0;
+};
+
+// Bounded multi-producer, multi-consumer queue. pop() returns nothing once the queue has been
+// closed and drained.
+template <typename T>
+class Channel {
+   public:
+    explicit Channel(size_t capacity) : capacity(std::max<size_t>(capacity, 1)) {}
+
+    // False if the channel was closed before there was room.
+    bool push(T value) {
+        std::unique_lock lock{mutex};
+        not_full.wait(lock, [&] { return closed || items.size() < capacity; });
+        if (closed) {
+            return false;
+        }
+        items.push_back(std::move(value));
+        not_empty.notify_one();
+        return true;
+    }
+
+    std::optional<T> pop() {
+        std::unique_lock lock{mutex};
+        not_empty.wait(lock, [&] { return closed || !items.empty(); });
+        if (items.empty()) {
+            return std::nullopt;
+        }
+        T value = std::move(items.front());
+        items.pop_front();
+        not_full.notify_one();
+        return value;
+    }
+
+    void close() {
+        std::lock_guard lock{mutex};
+        closed = true;
+        not_full.notify_all();
+        not_empty.notify_all();
+    }
+
+   private:
+    size_t capacity;
+    std::deque<T> items;
+    bool closed = false;
+    std::mutex mutex;
+    std::condition_variable not_full;
+    std::condition_variable not_empty;
+};
+
+// Runs parse(std::string_view block) on the reader thread and solve(records) on the workers,
+// and returns merge(...merge(merge(init, r0), r1)..., rn) over the per-block results r0..rn in
+// input order. A block's text outlives its records, so records may point into it. The first
+// exception thrown by any stage is rethrown here once every thread has stopped.
+template <typename Result, typename Parse, typename Solve, typename Merge>
+Result pipeline(std::istream& input,
+                Result init,
+                Parse parse,
+                Solve solve,
+                Merge merge,
+                PipelineOptions options = {}) {
+    using Records = std::invoke_result_t<Parse&, std::string_view>;
+    struct Block {
+        size_t index;
+        std::string text;
+        Records records;
+    };
+
+    Channel<std::unique_ptr<Block>> parsed{options.max_pending};
+    std::mutex mutex;
+    std::condition_variable solved_one;
+    std::map<size_t, Result> solved;
+    std::optional<size_t> num_blocks;
+    std::exception_ptr error;
+    bool stopping = false;
+
+    auto fail = [&] {
+        {
+            std::lock_guard lock{mutex};
+            if (!error) {
+                error = std::current_exception();
+            }
+            stopping = true;
+        }
+        parsed.close();
+        solved_one.notify_all();
+    };
+
+    auto read = [&] {
+        size_t count = 0;
+        try {
+            std::string carry;
+            while (input || !carry.empty()) {
+                auto block = std::make_unique<Block>();
+                block->index = count;
+                block->text = std::move(carry);
+                carry.clear();
+                const size_t start = block->text.size();
+                block->text.resize(start + options.block_size);
+                input.read(block->text.data() + start,
+                           static_cast<std::streamsize>(options.block_size));
+                block->text.resize(start + static_cast<size_t>(input.gcount()));
+                if (input) {
+                    const size_t end = block->text.rfind('\n');
+                    if (end == std::string::npos) {
+                        carry = std::move(block->text);
+                        continue;
+                    }
+                    carry.assign(block->text, end + 1);
+                    block->text.resize(end + 1);
+                }
+                if (block->text.empty()) {
+                    break;
+                }
+                block->records = parse(std::string_view{block->text});
+                if (!parsed.push(std::move(block))) {
+                    return;
+                }
+                count++;
+            }
+        } catch (...) {
+            fail();
+            return;
+        }
+        parsed.close();
+        std::lock_guard lock{mutex};
+        num_blocks = count;
+        solved_one.notify_all();
+    };
+
+    auto work = [&] {
+        try {
+            while (auto block = parsed.pop()) {
+                Result result = solve((*block)->records);
+                std::lock_guard lock{mutex};
+                solved.emplace((*block)->index, std::move(result));
+                solved_one.notify_all();
+            }
+        } catch (...) {
+            fail();
+        }
+    };
+
+    Result total = std::move(init);
+    {
+        const unsigned hardware = std::max(std::thread::hardware_concurrency(), 2u);
+        const unsigned num_workers = options.workers ? options.workers : hardware - 1;
+        std::jthread reader{read};
+        std::vector<std::jthread> workers;
+        for (unsigned i = 0; i < num_workers; i++) {
+            workers.emplace_back(work);
+        }
+
+        std::unique_lock lock{mutex};
+        for (size_t next = 0;; next++) {
+            solved_one.wait(lock, [&] {
+                return stopping || solved.contains(next) || (num_blocks && next == *num_blocks);
+            });
+            if (stopping || !solved.contains(next)) {
+                break;
+            }
+            auto node = solved.extract(next);
+            lock.unlock();
+            try {
+                total = merge(std::move(total), std::move(node.mapped()));
+            } catch (...) {
+                lock.lock();
+                if (!error) {
+                    error = std::current_exception();
+                }
+                stopping = true;
+                parsed.close();
+                break;
+            }
+            lock.lock();
+        }
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+    return total;
+}
+
+}  // namespace aoc
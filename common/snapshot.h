@@ -0,0 +1,267 @@
+#pragma once
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Preparsed inputs. A day can save the arrays it parses an input into as a snapshot file next to
+// the input and, on later runs over the same input, map that file and use the arrays in place
+// instead of parsing again.
+//
+// Layout: a SnapshotHeader, then one SnapshotSection per array, then the arrays themselves, each
+// starting at a multiple of 64 bytes. A snapshot is only used when its format version, the day's
+// schema number and the hash of the input text all match, so stale files are simply rewritten.
+namespace aoc {
+
+inline constexpr uint32_t snapshot_version = 1;
+inline constexpr size_t snapshot_alignment = 64;
+
+struct SnapshotHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t schema;
+    uint64_t source_hash;
+    uint64_t sections;
+};
+
+struct SnapshotSection {
+    uint64_t offset;
+    uint64_t count;
+    uint64_t element_size;
+};
+
+// 64-bit hash of the input text, eight bytes per step. The text can be fed in pieces of any
+// length as it is read, as long as its total size is known up front.
+class Hasher {
+   public:
+    explicit Hasher(uint64_t size) : hash(size * multiplier) {}
+
+    void update(std::string_view bytes) {
+        while (!bytes.empty() && (pending_size > 0 || bytes.size() < 8)) {
+            const size_t n = std::min(bytes.size(), 8 - pending_size);
+            std::memcpy(pending + pending_size, bytes.data(), n);
+            pending_size += n;
+            bytes.remove_prefix(n);
+            if (pending_size == 8) {
+                mix(pending);
+                pending_size = 0;
+            }
+        }
+        size_t i = 0;
+        for (; i + 8 <= bytes.size(); i += 8) {
+            mix(bytes.data() + i);
+        }
+        if (i < bytes.size()) {
+            std::memcpy(pending, bytes.data() + i, bytes.size() - i);
+            pending_size = bytes.size() - i;
+        }
+    }
+
+    uint64_t finish() {
+        char tail[8] = {};
+        std::memcpy(tail, pending, pending_size);
+        mix(tail);
+        return hash;
+    }
+
+   private:
+    static constexpr uint64_t multiplier = 0x9E3779B97F4A7C15;
+
+    void mix(char const* bytes) {
+        uint64_t word;
+        std::memcpy(&word, bytes, sizeof(word));
+        hash = (hash ^ word) * multiplier;
+        hash ^= hash >> 29;
+    }
+
+    uint64_t hash;
+    char pending[8] = {};
+    size_t pending_size = 0;
+};
+
+inline uint64_t hash_bytes(std::string_view bytes) {
+    Hasher hasher{bytes.size()};
+    hasher.update(bytes);
+    return hasher.finish();
+}
+
+class SnapshotWriter {
+   public:
+    // Appends an array as the next section. The bytes are copied as they are, so T must be
+    // trivially copyable and laid out the same way by the reader.
+    template <typename T>
+    void add(std::span<T const> elements) {
+        static_assert(std::is_trivially_copyable_v<T> && alignof(T) <= snapshot_alignment);
+        auto const* bytes = reinterpret_cast<char const*>(elements.data());
+        sections.push_back({{}, elements.size(), sizeof(T)});
+        data.emplace_back(bytes, bytes + elements.size_bytes());
+    }
+
+    // Writes the snapshot; false if the file could not be written, which callers can ignore.
+    bool write(std::string const& path, uint32_t schema, uint64_t source_hash) {
+        SnapshotHeader header{{'A', 'O', 'C', 'S', 'N', 'A', 'P', '\0'},
+                              snapshot_version,
+                              schema,
+                              source_hash,
+                              sections.size()};
+        uint64_t offset = aligned(sizeof(header) + sections.size() * sizeof(SnapshotSection));
+        for (size_t i = 0; i < sections.size(); i++) {
+            sections[i].offset = offset;
+            offset = aligned(offset + data[i].size());
+        }
+
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<char const*>(&header), sizeof(header));
+        file.write(reinterpret_cast<char const*>(sections.data()),
+                   static_cast<std::streamsize>(sections.size() * sizeof(SnapshotSection)));
+        for (size_t i = 0; i < sections.size(); i++) {
+            pad_to(file, sections[i].offset);
+            file.write(data[i].data(), static_cast<std::streamsize>(data[i].size()));
+        }
+        return static_cast<bool>(file);
+    }
+
+   private:
+    static uint64_t aligned(uint64_t offset) {
+        return (offset + snapshot_alignment - 1) / snapshot_alignment * snapshot_alignment;
+    }
+
+    static void pad_to(std::ofstream& file, uint64_t offset) {
+        static constexpr char zeros[snapshot_alignment] = {};
+        const auto position = static_cast<uint64_t>(file.tellp());
+        file.write(zeros, static_cast<std::streamsize>(offset - position));
+    }
+
+    std::vector<SnapshotSection> sections;
+    std::vector<std::vector<char>> data;
+};
+
+// A snapshot mapped copy-on-write: sections can be sorted or otherwise modified in place without
+// touching the file.
+class Snapshot {
+   public:
+    // The snapshot at `path` if it exists and matches, otherwise nothing.
+    static std::optional<Snapshot> open(std::string const& path,
+                                        uint32_t schema,
+                                        uint64_t source_hash) {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return std::nullopt;
+        }
+        struct stat info {};
+        void* mapping = MAP_FAILED;
+        if (::fstat(fd, &info) == 0 &&
+            static_cast<size_t>(info.st_size) >= sizeof(SnapshotHeader)) {
+            mapping = ::mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ | PROT_WRITE,
+                             MAP_PRIVATE, fd, 0);
+        }
+        ::close(fd);
+        if (mapping == MAP_FAILED) {
+            return std::nullopt;
+        }
+
+        Snapshot snapshot{static_cast<char*>(mapping), static_cast<size_t>(info.st_size)};
+        if (!snapshot.matches(schema, source_hash)) {
+            return std::nullopt;
+        }
+        return snapshot;
+    }
+
+    Snapshot(Snapshot&& other) noexcept
+        : base(std::exchange(other.base, nullptr)), size(std::exchange(other.size, 0)) {}
+
+    Snapshot& operator=(Snapshot&& other) noexcept {
+        std::swap(base, other.base);
+        std::swap(size, other.size);
+        return *this;
+    }
+
+    ~Snapshot() {
+        if (base) {
+            ::munmap(base, size);
+        }
+    }
+
+    // The index-th array, viewed in place.
+    template <typename T>
+    std::span<T> section(size_t index) const {
+        if (index >= header().sections) {
+            throw std::runtime_error("snapshot has no such section");
+        }
+        auto const& entry = sections()[index];
+        if (entry.element_size != sizeof(T)) {
+            throw std::runtime_error("snapshot section has the wrong element type");
+        }
+        return {reinterpret_cast<T*>(base + entry.offset), static_cast<size_t>(entry.count)};
+    }
+
+   private:
+    Snapshot(char* base, size_t size) : base(base), size(size) {}
+
+    SnapshotHeader const& header() const { return *reinterpret_cast<SnapshotHeader const*>(base); }
+
+    std::span<SnapshotSection const> sections() const {
+        return {reinterpret_cast<SnapshotSection const*>(base + sizeof(SnapshotHeader)),
+                static_cast<size_t>(header().sections)};
+    }
+
+    bool matches(uint32_t schema, uint64_t source_hash) const {
+        auto const& h = header();
+        if (std::memcmp(h.magic, "AOCSNAP", 8) != 0 || h.version != snapshot_version ||
+            h.schema != schema || h.source_hash != source_hash ||
+            sizeof(SnapshotHeader) + h.sections * sizeof(SnapshotSection) > size) {
+            return false;
+        }
+        for (auto const& entry : sections()) {
+            if (entry.offset % snapshot_alignment != 0 ||
+                entry.offset + entry.count * entry.element_size > size) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    char* base = nullptr;
+    size_t size = 0;
+};
+
+// An input file and the snapshot saved next to it, if that matches the input.
+struct SnapshotInput {
+    std::ifstream stream;
+    std::optional<Snapshot> snapshot;
+};
+
+// Opens `path` and maps `path`.snapshot when it matches `schema` and the input's text. The text
+// is only read to hash it when a snapshot file exists, and the stream is left at its start
+// either way; if the input could not be opened the stream is returned failed.
+inline SnapshotInput open_or_stream(std::string const& path, uint32_t schema) {
+    SnapshotInput input{std::ifstream{path, std::ios::binary}, std::nullopt};
+    const std::string snapshot_path = path + ".snapshot";
+    if (!input.stream || !std::filesystem::exists(snapshot_path)) {
+        return input;
+    }
+    std::string text(std::filesystem::file_size(path), '\0');
+    input.stream.read(text.data(), static_cast<std::streamsize>(text.size()));
+    text.resize(static_cast<size_t>(input.stream.gcount()));
+    input.snapshot = Snapshot::open(snapshot_path, schema, hash_bytes(text));
+    input.stream.clear();
+    input.stream.seekg(0);
+    return input;
+}
+
+}  // namespace aoc
@@ -1,67 +1,155 @@
+#include <array>
+#include <cstdint>
+#include <filesystem>
 #include <fstream>
 #include <iostream>
 #include <span>
 #include <string>
+#include <string_view>
+#include <utility>
 #include <vector>
 
+#include "../common/memory.h"
+#include "../common/parse.h"
+#include "../common/pipeline.h"
+#include "../common/snapshot.h"
+
 struct Turn {
     char direction;
     int distance;
 };
 
-int part1(const std::span<Turn>& t) {
-    int dial_position{50};
-    int num_zeros{0};
+// A run of turns' effect on the dial for each of the 100 starting positions.
+struct Sweep {
+    int shift = 0;
+    std::array<int64_t, 100> landed{};
+    std::array<int64_t, 100> passed{};
+
+    // This run followed by `next`.
+    constexpr Sweep then(Sweep const& next) const {
+        Sweep result;
+        result.shift = (shift + next.shift) % 100;
+        for (int start = 0; start < 100; start++) {
+            const int middle = (start + shift) % 100;
+            result.landed[start] = landed[start] + next.landed[middle];
+            result.passed[start] = passed[start] + next.passed[middle];
+        }
+        return result;
+    }
+};
 
-    for (auto turn : t) {
+// One pass over the turns, adding to ranges of starting positions through a difference array.
+constexpr Sweep sweep(std::span<const Turn> turns) {
+    Sweep result;
+    std::array<int64_t, 101> starts{};
+    int64_t full_turns = 0;
+    auto add = [&](int from, int length) {
+        if (length == 0) {
+            return;
+        }
+        const int first = (from - result.shift + 100) % 100;
+        starts[first]++;
+        if (first + length <= 100) {
+            starts[first + length]--;
+        } else {
+            starts[100]--;
+            starts[0]++;
+            starts[first + length - 100]--;
+        }
+    };
+    for (auto turn : turns) {
+        full_turns += turn.distance / 100;
+        const int rest = turn.distance % 100;
         if (turn.direction == 'R') {
-            dial_position += turn.distance;
+            add(100 - rest, rest);
+            result.shift = (result.shift + rest) % 100;
         } else if (turn.direction == 'L') {
-            dial_position -= turn.distance;
-        }
-        dial_position = (dial_position + 100) % 100;
-        if (dial_position == 0) {
-            num_zeros++;
+            add(1, rest);
+            result.shift = (result.shift - rest + 100) % 100;
         }
+        result.landed[(100 - result.shift) % 100]++;
+    }
+    int64_t running = 0;
+    for (int start = 0; start < 100; start++) {
+        running += starts[start];
+        result.passed[start] = full_turns + running;
     }
-    return num_zeros;
+    return result;
 }
 
-int part2(const std::span<Turn>& t) {
-    int dial_position{50};
-    int num_zeros{0};
+constexpr int64_t part1(std::span<const Turn> t) {
+    return sweep(t).landed[50];
+}
 
-    for (auto turn : t) {
-        if (turn.direction == 'R') {
-            for (int i = 0; i < turn.distance; i++) {
-                dial_position++;
-                if (dial_position % 100 == 0) {
-                    num_zeros++;
-                }
-            }
-        } else if (turn.direction == 'L') {
-            for (int i = 0; i < turn.distance; i++) {
-                dial_position--;
-                if (dial_position % 100 == 0) {
-                    num_zeros++;
-                }
-            }
-        }
-        dial_position = (dial_position + 100) % 100;
+constexpr int64_t part2(std::span<const Turn> t) {
+    return sweep(t).passed[50];
+}
+
+constexpr std::vector<Turn> parse(std::string_view text) {
+    std::vector<Turn> turns;
+    for (aoc::Scanner scanner{text}; !scanner.done(); scanner.consume('\n')) {
+        char direction = scanner.next();
+        turns.push_back({direction, scanner.number<int>()});
     }
-    return num_zeros;
+    return turns;
 }
 
+#ifdef AOC_EMBED_INPUT
+#define AOC_EMBED_FILE "../day1/puzzle.txt"
+#define AOC_EMBED_XXD "../day1/puzzle.txt.inc"
+#include "../common/embed.h"
+
+constexpr auto answers = [] {
+    const auto turns = parse(aoc::embedded_input);
+    return std::pair{part1(turns), part2(turns)};
+}();
+
+int main() {
+    std::cout << answers.first << std::endl;
+    std::cout << answers.second << std::endl;
+    return 0;
+}
+#else
 int main() {
-    std::ifstream puzzle("puzzle.txt");
-    std::vector<Turn> t = {};
-    for (std::string line; std::getline(puzzle, line);) {
-        char direction = line[0];
-        int distance = stoi(line.substr(1));
-        t.push_back({line[0], distance});
+    constexpr uint32_t schema = 1;
+    auto [puzzle, snapshot] = aoc::open_or_stream("puzzle.txt", schema);
+    if (!puzzle) {
+        std::cerr << "Error opening file" << std::endl;
+        return 1;
+    }
+    if (snapshot) {
+        Sweep total;
+        {
+            aoc::Phase phase{"solve"};
+            total = sweep(snapshot->section<Turn>(0));
+        }
+        std::cout << total.landed[50] << std::endl;
+        std::cout << total.passed[50] << std::endl;
+        return 0;
+    }
+
+    aoc::Hasher hasher{std::filesystem::file_size("puzzle.txt")};
+    std::vector<Turn> parsed;
+    Sweep total;
+    {
+        aoc::Phase phase{"solve"};
+        total = aoc::pipeline(
+            puzzle, Sweep{},
+            [&](std::string_view block) {
+                hasher.update(block);
+                auto turns = parse(block);
+                parsed.insert(parsed.end(), turns.begin(), turns.end());
+                return turns;
+            },
+            [](std::vector<Turn> const& turns) { return sweep(turns); },
+            [](Sweep const& done, Sweep const& next) { return done.then(next); });
     }
-    std::cout << part1(t) << std::endl;
-    std::cout << part2(t) << std::endl;
+    aoc::SnapshotWriter writer;
+    writer.add<Turn>(parsed);
+    writer.write("puzzle.txt.snapshot", schema, hasher.finish());
 
+    std::cout << total.landed[50] << std::endl;
+    std::cout << total.passed[50] << std::endl;
     return 0;
 }
+#endif
@@ -1,13 +1,23 @@
 from conan import ConanFile
-from conan.tools.cmake import cmake_layout
+from conan.tools.cmake import CMakeToolchain, cmake_layout
 
 
 class ExampleRecipe(ConanFile):
     settings = "os", "compiler", "build_type", "arch"
-    generators = "CMakeDeps", "CMakeToolchain"
+    generators = "CMakeDeps"
+    # z3 is only needed to cross-check the joltage solver, see WITH_Z3 in main.cpp.
+    options = {"with_z3": [True, False]}
+    default_options = {"with_z3": False}
 
     def requirements(self):
-        self.requires("z3/4.15.4")
+        if self.options.with_z3:
+            self.requires("z3/4.15.4")
+
+    def generate(self):
+        toolchain = CMakeToolchain(self)
+        if self.options.with_z3:
+            toolchain.preprocessor_definitions["WITH_Z3"] = 1
+        toolchain.generate()
 
     def layout(self):
         cmake_layout(self)
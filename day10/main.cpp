@@ -1,96 +1,495 @@
 #include <algorithm>
+#include <bit>
+#include <bitset>
+#include <cmath>
+#include <exception>
 #include <fstream>
+#include <functional>
 #include <iostream>
+#include <limits>
+#include <mutex>
 #include <numeric>
-#include <queue>
+#include <optional>
 #include <ranges>
 #include <sstream>
+#include <stdexcept>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
+#include "../common/memory.h"
+#include "../common/parse.h"
+#include "../common/pipeline.h"
+
+#ifdef WITH_Z3
 #include "z3++.h"
+#endif
 
 using std::stringstream;
 
 using namespace std;
 
-vector<int> parse_numbers(string data) {
-    return data | views::split(',') |
-           views::transform([](auto&& s) { return stoi(std::string(begin(s), end(s))); }) |
-           std::ranges::to<std::vector<int>>();
-}
-
-struct Entry {
-    int lights{};
-    int presses{};
-};
-
 struct Machine {
     Machine() = delete;
-    Machine(string data) {
-        vector<std::string> parts;
-        auto start = data.begin();
-        auto it = find(start, end(data), ' ');
-
-        while (it != end(data)) {
-            parts.push_back(string(start, it));
-            start = it + 1;
-            it = find(start, end(data), ' ');
-        }
-        parts.push_back(string(start, end(data)));
-
-        string last = parts.back();
-        parts.pop_back();
-        joltages = parse_numbers(last.substr(1, last.size() - 2));
-
-        string front = parts.front();
-        parts.erase(parts.begin());
-        auto lights = front.substr(1, front.size() - 2);
-        goal = ranges::fold_left(string(lights.rbegin(), lights.rend()), 0,
+    Machine(string_view data) {
+        aoc::Scanner scanner{data};
+        scanner.expect('[');
+        string_view lights = scanner.until(']');
+        scanner.expect(']');
+        goal = ranges::fold_left(lights | views::reverse, 0,
                                  [](int acc, char c) { return c == '#' ? acc * 2 + 1 : acc * 2; });
 
-        buttons =
-            parts |
-            views::transform([](auto&& s) { return parse_numbers(s.substr(1, s.size() - 2)); }) |
-            std::ranges::to<std::vector<vector<int>>>();
+        scanner.skip(' ');
+        while (scanner.consume('(')) {
+            buttons.push_back(aoc::numbers<int>(scanner.until(')')));
+            scanner.expect(')');
+            scanner.skip(' ');
+        }
+
+        scanner.expect('{');
+        joltages = aoc::numbers<int>(scanner.until('}'));
+        scanner.expect('}');
     }
 
-    void press(Entry& entry, vector<int> buttons) {
-        for (auto& button : buttons) {
-            entry.lights ^= 1 << button;
-        }
-        entry.presses++;
+    // Lights toggled by each button, one bit per light.
+    vector<uint64_t> button_masks() const {
+        return buttons | views::transform([](vector<int> const& button) {
+                   return ranges::fold_left(button, uint64_t{0}, [](uint64_t mask, int light) {
+                       return mask | (uint64_t{1} << light);
+                   });
+               }) |
+               ranges::to<vector<uint64_t>>();
     }
 
-    int find_fewest_presses() {
-        queue<Entry> q;
-        q.push({0, 0});
-        vector<int> seen;
+    // Lightest solution of A.p = goal over GF(2), by whichever search is cheapest and fits in
+    // 2^max_table_bits table entries.
+    int find_fewest_presses() const {
+        constexpr size_t max_table_bits = 22;
+        auto masks = button_masks();
+        if (masks.size() > 64) {
+            throw std::runtime_error("too many buttons");
+        }
 
-        while (!q.empty()) {
-            auto entry = q.front();
-            q.pop();
+        // One row per light: the buttons touching it, plus the wanted state in bit 64.
+        vector<bitset<65>> rows;
+        for (size_t light = 0; light < 64; light++) {
+            bitset<65> row;
+            for (size_t b = 0; b < masks.size(); b++) {
+                row[b] = (masks[b] >> light) & 1;
+            }
+            row[64] = (static_cast<uint64_t>(goal) >> light) & 1;
+            if (row.any()) {
+                rows.push_back(row);
+            }
+        }
 
-            if (entry.lights == goal) {
-                return entry.presses;
+        vector<size_t> pivots;
+        for (size_t b = 0; b < masks.size() && pivots.size() < rows.size(); b++) {
+            auto it = find_if(rows.begin() + pivots.size(), rows.end(),
+                              [b](auto const& row) { return row[b]; });
+            if (it == rows.end()) {
+                continue;
             }
+            swap(*it, rows[pivots.size()]);
+            for (size_t r = 0; r < rows.size(); r++) {
+                if (r != pivots.size() && rows[r][b]) {
+                    rows[r] ^= rows[pivots.size()];
+                }
+            }
+            pivots.push_back(b);
+        }
+        for (size_t r = pivots.size(); r < rows.size(); r++) {
+            if (rows[r][64]) {
+                throw std::runtime_error("no solution");
+            }
+        }
 
-            if (find(seen.begin(), seen.end(), entry.lights) != seen.end()) {
+        uint64_t particular = 0;
+        uint64_t pivot_set = 0;
+        for (size_t r = 0; r < pivots.size(); r++) {
+            particular |= static_cast<uint64_t>(rows[r][64]) << pivots[r];
+            pivot_set |= uint64_t{1} << pivots[r];
+        }
+        vector<uint64_t> null_space;
+        for (size_t b = 0; b < masks.size(); b++) {
+            if ((pivot_set >> b) & 1) {
                 continue;
             }
-            seen.push_back(entry.lights);
+            uint64_t basis = uint64_t{1} << b;
+            for (size_t r = 0; r < pivots.size(); r++) {
+                if (rows[r][b]) {
+                    basis |= uint64_t{1} << pivots[r];
+                }
+            }
+            null_space.push_back(basis);
+        }
+
+        // Costs as powers of two. The walk needs no memory, so it is the fallback.
+        const size_t num_lights =
+            bit_width(ranges::fold_left(masks, static_cast<uint64_t>(goal), bit_or{}));
+        constexpr size_t too_big = numeric_limits<size_t>::max();
+        const size_t walk_cost = null_space.size();
+        const size_t half = masks.size() / 2;
+        const size_t meet_cost =
+            half <= max_table_bits ? masks.size() - half + bit_width(half) : too_big;
+        const size_t search_cost =
+            num_lights <= max_table_bits ? num_lights + bit_width(masks.size()) : too_big;
+        if (meet_cost < walk_cost && meet_cost <= search_cost) {
+            return meet_in_the_middle(masks);
+        }
+        if (search_cost < walk_cost) {
+            return breadth_first(masks, num_lights);
+        }
+        uint64_t presses = particular;
+        int fewest = popcount(presses);
+        for (uint64_t i = 1; i < (uint64_t{1} << null_space.size()); i++) {
+            presses ^= null_space[countr_zero(i)];
+            fewest = min(fewest, popcount(presses));
+        }
+        return fewest;
+    }
 
-            for (auto& button : buttons) {
-                auto new_entry = entry;
-                press(new_entry, button);
-                q.push(new_entry);
+    // Breadth-first search over the 2^num_lights light states.
+    int breadth_first(vector<uint64_t> const& masks, size_t num_lights) const {
+        vector<bool> seen(size_t{1} << num_lights, false);
+        vector<uint64_t> frontier{0};
+        seen[0] = true;
+        for (int presses = 0; !frontier.empty(); presses++) {
+            vector<uint64_t> next;
+            for (uint64_t lights : frontier) {
+                if (lights == static_cast<uint64_t>(goal)) {
+                    return presses;
+                }
+                for (uint64_t mask : masks) {
+                    if (!seen[lights ^ mask]) {
+                        seen[lights ^ mask] = true;
+                        next.push_back(lights ^ mask);
+                    }
+                }
             }
+            frontier = std::move(next);
         }
         throw std::runtime_error("no solution");
     }
 
-    uint64_t solve() {
-        z3::context ctx;
+    // Meet in the middle over the two halves of the buttons, each walked in Gray code order.
+    int meet_in_the_middle(vector<uint64_t> const& masks) const {
+        const size_t half = masks.size() / 2;
+        vector<pair<uint64_t, int>> first{{0, 0}};
+        first.reserve(size_t{1} << half);
+        uint64_t lights = 0;
+        for (uint64_t i = 1; i < (uint64_t{1} << half); i++) {
+            lights ^= masks[countr_zero(i)];
+            first.emplace_back(lights, popcount(i ^ (i >> 1)));
+        }
+        ranges::sort(first);
+
+        optional<int> fewest;
+        lights = static_cast<uint64_t>(goal);
+        for (uint64_t i = 0; i < (uint64_t{1} << (masks.size() - half)); i++) {
+            if (i > 0) {
+                lights ^= masks[half + countr_zero(i)];
+            }
+            auto it = ranges::lower_bound(first, pair{lights, 0});
+            if (it != first.end() && it->first == lights) {
+                const int presses = it->second + popcount(i ^ (i >> 1));
+                fewest = min(fewest.value_or(presses), presses);
+            }
+        }
+        if (!fewest) {
+            throw std::runtime_error("no solution");
+        }
+        return *fewest;
+    }
+
+    // LP dual prices y with y.a <= 1 for every button column a, so y.needs bounds the presses
+    // still needed. Solved by a Big-M simplex.
+    vector<double> light_prices(vector<vector<int>> const& distinct) const {
+        const size_t num_lights = joltages.size();
+        const size_t num_buttons = distinct.size();
+        const size_t rhs = num_buttons + num_lights;
+        // One artificial column per light starts the basis; it costs more than any solution.
+        const double big = 1.0 + ranges::fold_left(joltages, 0.0, plus{});
+        vector<vector<double>> tableau(num_lights + 1, vector<double>(rhs + 1, 0.0));
+        vector<size_t> basis(num_lights);
+        for (size_t j = 0; j < num_lights; j++) {
+            for (size_t b = 0; b < num_buttons; b++) {
+                tableau[j][b] = ranges::binary_search(distinct[b], static_cast<int>(j));
+            }
+            tableau[j][num_buttons + j] = 1.0;
+            tableau[j][rhs] = joltages[j];
+            basis[j] = num_buttons + j;
+        }
+        // The last row holds the reduced costs.
+        auto& costs = tableau[num_lights];
+        for (size_t k = 0; k < rhs; k++) {
+            costs[k] = k < num_buttons ? 1.0 : big;
+        }
+        for (size_t j = 0; j < num_lights; j++) {
+            for (size_t k = 0; k <= rhs; k++) {
+                costs[k] -= big * tableau[j][k];
+            }
+        }
+
+        // Bland's rule: the lowest improving column enters, so the simplex cannot cycle.
+        constexpr double epsilon = 1e-9;
+        for (;;) {
+            size_t enter = 0;
+            while (enter < rhs && costs[enter] > -epsilon) {
+                enter++;
+            }
+            if (enter == rhs) {
+                break;
+            }
+            optional<size_t> leave;
+            for (size_t j = 0; j < num_lights; j++) {
+                if (tableau[j][enter] <= epsilon) {
+                    continue;
+                }
+                if (!leave) {
+                    leave = j;
+                    continue;
+                }
+                const double ratio = tableau[j][rhs] / tableau[j][enter];
+                const double lowest = tableau[*leave][rhs] / tableau[*leave][enter];
+                if (ratio < lowest - epsilon ||
+                    (ratio < lowest + epsilon && basis[j] < basis[*leave])) {
+                    leave = j;
+                }
+            }
+            if (!leave) {
+                break;
+            }
+            auto& pivot = tableau[*leave];
+            const double scale = pivot[enter];
+            ranges::for_each(pivot, [scale](double& v) { v /= scale; });
+            for (size_t j = 0; j <= num_lights; j++) {
+                if (j != *leave && tableau[j][enter] != 0.0) {
+                    const double factor = tableau[j][enter];
+                    for (size_t k = 0; k <= rhs; k++) {
+                        tableau[j][k] -= factor * pivot[k];
+                    }
+                }
+            }
+            basis[*leave] = enter;
+        }
+
+        // An artificial column's reduced cost is its cost less its light's price.
+        vector<double> prices(num_lights);
+        for (size_t j = 0; j < num_lights; j++) {
+            prices[j] = big - costs[num_buttons + j];
+        }
+        double most = 1.0;
+        for (auto const& button : distinct) {
+            double covered = 0.0;
+            for (int j : button) {
+                covered += prices[j];
+            }
+            most = max(most, covered);
+        }
+        ranges::for_each(prices, [most](double& price) { price /= most; });
+        return prices;
+    }
+
+    // Fewest presses with A.p = joltages, p >= 0 integer: elimination, then branch and bound
+    // over the free buttons.
+    uint64_t solve() const {
+        // Only distinct, non-empty buttons are searched.
+        vector<vector<int>> distinct = buttons;
+        for (auto& button : distinct) {
+            ranges::sort(button);
+            button.erase(ranges::unique(button).begin(), button.end());
+        }
+        ranges::sort(distinct);
+        distinct.erase(ranges::unique(distinct).begin(), distinct.end());
+        erase_if(distinct, [](vector<int> const& button) { return button.empty(); });
+
+        const size_t num_buttons = distinct.size();
+        vector<vector<int64_t>> rows(joltages.size(), vector<int64_t>(num_buttons + 1, 0));
+        for (size_t b = 0; b < num_buttons; b++) {
+            for (int j : distinct[b]) {
+                rows[j][b] = 1;
+            }
+        }
+        for (size_t j = 0; j < joltages.size(); j++) {
+            rows[j][num_buttons] = joltages[j];
+        }
+
+        vector<size_t> pivots;
+        for (size_t b = 0; b < num_buttons && pivots.size() < rows.size(); b++) {
+            auto it = find_if(rows.begin() + pivots.size(), rows.end(),
+                              [b](auto const& row) { return row[b] != 0; });
+            if (it == rows.end()) {
+                continue;
+            }
+            auto& pivot = rows[pivots.size()];
+            swap(*it, pivot);
+            if (pivot[b] < 0) {
+                ranges::for_each(pivot, [](int64_t& v) { v = -v; });
+            }
+            for (auto& row : rows) {
+                if (&row == &pivot || row[b] == 0) {
+                    continue;
+                }
+                const int64_t factor = row[b];
+                int64_t divisor = 0;
+                for (size_t k = 0; k <= num_buttons; k++) {
+                    row[k] = row[k] * pivot[b] - pivot[k] * factor;
+                    divisor = gcd(divisor, row[k]);
+                }
+                if (divisor > 1) {
+                    ranges::for_each(row, [divisor](int64_t& v) { v /= divisor; });
+                }
+            }
+            pivots.push_back(b);
+        }
+        for (size_t r = pivots.size(); r < rows.size(); r++) {
+            if (rows[r][num_buttons] != 0) {
+                throw std::runtime_error("no solution");
+            }
+        }
+        rows.resize(pivots.size());
+
+        vector<size_t> free;
+        for (size_t b = 0; b < num_buttons; b++) {
+            if (ranges::find(pivots, b) == pivots.end()) {
+                free.push_back(b);
+            }
+        }
+
+        // Per free button, how much one press changes the total once the pivots absorb it.
+        vector<double> slope(free.size(), 1.0);
+        for (size_t k = 0; k < free.size(); k++) {
+            for (size_t r = 0; r < rows.size(); r++) {
+                slope[k] -= static_cast<double>(rows[r][free[k]]) / rows[r][pivots[r]];
+            }
+        }
+        int64_t widest = 1;
+        for (auto const& button : distinct) {
+            widest = max(widest, static_cast<int64_t>(button.size()));
+        }
+
+        int64_t best = 0;
+        vector<int64_t> residual(rows.size());
+        for (size_t r = 0; r < rows.size(); r++) {
+            residual[r] = rows[r][num_buttons];
+        }
+        // What each light still needs from the pivots and the free buttons not yet fixed.
+        vector<int64_t> needs(joltages.begin(), joltages.end());
+        vector<bool> fixed(free.size(), false);
+        vector<int64_t> caps(free.size());
+        vector<vector<int64_t>> lifts(free.size(), vector<int64_t>(rows.size()));
+        const vector<double> prices = light_prices(distinct);
+
+        // Fewest presses that could still meet the lights' needs.
+        auto still_needed = [&] {
+            const int64_t neediest = ranges::max(needs);
+            const int64_t needed = ranges::fold_left(needs, int64_t{0}, plus{});
+            double priced = 0.0;
+            for (size_t j = 0; j < needs.size(); j++) {
+                priced += prices[j] * static_cast<double>(needs[j]);
+            }
+            return max({neediest, (needed + widest - 1) / widest,
+                        static_cast<int64_t>(ceil(priced - 1e-6))});
+        };
+
+        auto search = [&](auto& self, size_t depth, int64_t pressed) -> void {
+            if (pressed + still_needed() >= best) {
+                return;
+            }
+            if (depth == free.size()) {
+                int64_t total = pressed;
+                for (size_t r = 0; r < rows.size(); r++) {
+                    const int64_t diagonal = rows[r][pivots[r]];
+                    if (residual[r] < 0 || residual[r] % diagonal != 0) {
+                        return;
+                    }
+                    total += residual[r] / diagonal;
+                }
+                best = min(best, total);
+                return;
+            }
+
+            // Branch on the free button with the fewest choices left.
+            size_t pick = free.size();
+            for (size_t k = 0; k < free.size(); k++) {
+                if (fixed[k]) {
+                    continue;
+                }
+                caps[k] = numeric_limits<int64_t>::max();
+                for (int j : distinct[free[k]]) {
+                    caps[k] = min(caps[k], needs[j]);
+                }
+                if (pick == free.size() || caps[k] < caps[pick]) {
+                    pick = k;
+                }
+            }
+            double lowest_gain = 0.0;
+            vector<int64_t>& highest_lift = lifts[depth];
+            ranges::fill(highest_lift, 0);
+            for (size_t k = 0; k < free.size(); k++) {
+                if (fixed[k] || k == pick) {
+                    continue;
+                }
+                lowest_gain += min(0.0, slope[k] * static_cast<double>(caps[k]));
+                for (size_t r = 0; r < rows.size(); r++) {
+                    highest_lift[r] -= min<int64_t>(0, rows[r][free[k]] * caps[k]);
+                }
+            }
+            const size_t button = free[pick];
+            const int64_t cap = caps[pick];
+
+            fixed[pick] = true;
+            // Presses that lower the total are tried first, to tighten best early.
+            for (int64_t i = 0; i <= cap; i++) {
+                const int64_t presses = slope[pick] < 0 ? cap - i : i;
+                bool feasible = true;
+                double bound = static_cast<double>(pressed + presses) + lowest_gain;
+                for (size_t r = 0; r < rows.size(); r++) {
+                    const int64_t left = residual[r] - rows[r][button] * presses;
+                    feasible = feasible && left + highest_lift[r] >= 0;
+                    bound += static_cast<double>(left) / rows[r][pivots[r]];
+                }
+                // Totals are integers, so nothing below here can beat best once bound > best - 1.
+                if (!feasible || bound > static_cast<double>(best) - 1 + 1e-6) {
+                    continue;
+                }
+                for (size_t r = 0; r < rows.size(); r++) {
+                    residual[r] -= rows[r][button] * presses;
+                }
+                for (int j : distinct[button]) {
+                    needs[j] -= presses;
+                }
+                self(self, depth + 1, pressed + presses);
+                for (size_t r = 0; r < rows.size(); r++) {
+                    residual[r] += rows[r][button] * presses;
+                }
+                for (int j : distinct[button]) {
+                    needs[j] += presses;
+                }
+            }
+            fixed[pick] = false;
+        };
+        // Iterative deepening from the root's bound: the first limit with a solution is optimal.
+        const int64_t lowest = still_needed();
+        const int64_t highest = ranges::fold_left(joltages, int64_t{0}, plus{});
+        for (int64_t slack = 0;; slack = max<int64_t>(1, 2 * slack)) {
+            const int64_t limit = min(lowest + slack, highest);
+            best = limit + 1;
+            search(search, 0, 0);
+            if (best <= limit) {
+                return static_cast<uint64_t>(best);
+            }
+            if (limit == highest) {
+                throw std::runtime_error("no solution");
+            }
+        }
+    }
+
+#ifdef WITH_Z3
+    // Reference solver used to cross-check solve() when built with WITH_Z3.
+    uint64_t solve_z3() const {
+        thread_local z3::context ctx;
         z3::expr_vector presses(ctx);
         z3::optimize opt(ctx);
 
@@ -123,35 +522,130 @@ struct Machine {
         }
         return 0;
     }
+#endif
 
     int goal;
     vector<int> joltages;
     vector<vector<int>> buttons;
 };
 
-int part1(vector<Machine> const& machines) {
-    return accumulate(machines.begin(), machines.end(), 0,
-                      [](int acc, Machine machine) { return acc + machine.find_fewest_presses(); });
+// Machine description with lights and buttons sorted, so reordered machines compare equal.
+vector<vector<int>> canonical_buttons(Machine const& machine) {
+    auto buttons = machine.buttons;
+    ranges::for_each(buttons, [](vector<int>& button) { ranges::sort(button); });
+    ranges::sort(buttons);
+    return buttons;
 }
 
-int part2(vector<Machine> const& machines) {
-    return accumulate(machines.begin(), machines.end(), 0,
-                      [](int acc, Machine machine) { return acc + machine.solve(); });
+string light_signature(Machine const& machine) {
+    string signature = to_string(machine.goal);
+    for (auto const& button : canonical_buttons(machine)) {
+        signature += '|';
+        for (int light : button) {
+            signature += to_string(light) + ',';
+        }
+    }
+    return signature;
 }
 
-int main() {
-    std::ifstream file("puzzle.txt");
+string joltage_signature(Machine const& machine) {
+    string signature;
+    for (int joltage : machine.joltages) {
+        signature += to_string(joltage) + ',';
+    }
+    for (auto const& button : canonical_buttons(machine)) {
+        signature += '|';
+        for (int light : button) {
+            signature += to_string(light) + ',';
+        }
+    }
+    return signature;
+}
+
+// Answers by machine signature, shared by the pipeline's workers.
+class Solved {
+   public:
+    template <typename Solve>
+    uint64_t find_or_solve(string key, Solve solve) {
+        {
+            lock_guard lock{guard};
+            if (auto it = answers.find(key); it != answers.end()) {
+                return it->second;
+            }
+        }
+        const uint64_t answer = solve();
+        lock_guard lock{guard};
+        answers.emplace(std::move(key), answer);
+        return answer;
+    }
+
+   private:
+    mutex guard;
+    unordered_map<string, uint64_t> answers;
+};
 
-    std::vector<Machine> machines;
-    std::string line;
-    while (std::getline(file, line)) {
-        machines.push_back(Machine(line));
+struct Answers {
+    uint64_t part1 = 0;
+    uint64_t part2 = 0;
+};
+
+// Both answers for a block of machines.
+Answers solve_block(vector<Machine> const& machines, Solved& lights, Solved& joltages) {
+    Answers answers;
+    for (auto const& machine : machines) {
+        answers.part1 += lights.find_or_solve(light_signature(machine), [&]() -> uint64_t {
+            return machine.find_fewest_presses();
+        });
+        answers.part2 += joltages.find_or_solve(joltage_signature(machine), [&]() -> uint64_t {
+            const uint64_t presses = machine.solve();
+#ifdef WITH_Z3
+            if (presses != machine.solve_z3()) {
+                throw runtime_error("solve() disagrees with z3");
+            }
+#endif
+            return presses;
+        });
     }
+    return answers;
+}
 
+vector<Machine> parse(string_view text) {
+    vector<Machine> machines;
+    for (aoc::Scanner scanner{text}; !scanner.done();) {
+        if (auto line = scanner.line(); !line.empty()) {
+            machines.push_back(Machine(line));
+        }
+    }
+    return machines;
+}
+
+int main() {
+    // Small blocks, so even a short input's machines spread over all the workers.
+    std::ifstream file("puzzle.txt");
+    if (!file) {
+        std::cerr << "Error opening file" << std::endl;
+        return 1;
+    }
+    Solved lights;
+    Solved joltages;
     try {
-        println("{}", part1(machines));
-        println("{}", part2(machines));
+        Answers answers;
+        {
+            aoc::Phase phase{"solve"};
+            answers = aoc::pipeline(
+                file, Answers{}, parse,
+                [&](vector<Machine> const& machines) {
+                    return solve_block(machines, lights, joltages);
+                },
+                [](Answers total, Answers block) {
+                    return Answers{total.part1 + block.part1, total.part2 + block.part2};
+                },
+                aoc::PipelineOptions{.block_size = 512});
+        }
+        println("{}", answers.part1);
+        println("{}", answers.part2);
     } catch (std::exception& e) {
         std::cout << e.what() << std::endl;
+        return 1;
     }
 }
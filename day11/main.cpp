@@ -1,89 +1,828 @@
 #include <algorithm>
 #include <array>
-#include <format>
 #include <fstream>
 #include <iostream>
+#include <limits>
+#include <list>
 #include <numeric>
+#include <optional>
+#include <queue>
 #include <ranges>
+#include <span>
+#include <stdexcept>
 #include <string>
+#include <string_view>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
+#include "../common/memory.h"
+#include "../common/parse.h"
+#include "../common/snapshot.h"
+
+#ifdef AOC_SELF_TEST
+#include <random>
+#endif
+
+// Moves a node's per-waypoint-subset counts to account for it being the waypoints in `bits`.
+void absorb_waypoints(std::span<uint64_t> block, uint32_t bits) {
+    if (bits == 0) {
+        return;
+    }
+    for (size_t mask = 0; mask < block.size(); mask++) {
+        if ((mask & bits) != bits) {
+            block[mask | bits] += std::exchange(block[mask], 0);
+        }
+    }
+}
+
 struct PathFinder {
     PathFinder() = delete;
-    PathFinder(std::unordered_map<std::string, std::vector<std::string>> devices)
-        : devices(devices) {}
+    PathFinder(std::unordered_map<std::string, std::vector<std::string>> const& devices) {
+        std::vector<std::string> names;
+        std::unordered_map<std::string, uint32_t> ids;
+        auto intern = [&](std::string const& name) {
+            auto [it, inserted] = ids.try_emplace(name, static_cast<uint32_t>(names.size()));
+            if (inserted) {
+                names.push_back(name);
+            }
+            return it->second;
+        };
+        for (auto const& [name, outputs] : devices) {
+            intern(name);
+            for (auto const& output : outputs) {
+                intern(output);
+            }
+        }
+
+        // CSR: the outputs of node v are targets[offsets[v] .. offsets[v + 1]).
+        built.offsets.assign(names.size() + 1, 0);
+        for (auto const& [name, outputs] : devices) {
+            built.offsets[ids[name] + 1] = outputs.size();
+        }
+        std::partial_sum(built.offsets.begin(), built.offsets.end(), built.offsets.begin());
+        built.targets.resize(built.offsets.back());
+        for (auto const& [name, outputs] : devices) {
+            std::ranges::transform(outputs, built.targets.begin() + built.offsets[ids[name]],
+                                   [&](std::string const& output) { return ids[output]; });
+        }
 
-    uint32_t search(std::string dest) {
-        if (dest == "out") {
-            return 1;
+        // Names as chars[name_ends[v - 1] .. name_ends[v]), plus the nodes in name order.
+        for (auto const& name : names) {
+            built.chars.insert(built.chars.end(), name.begin(), name.end());
+            built.name_ends.push_back(static_cast<uint32_t>(built.chars.size()));
         }
+        built.by_name.resize(names.size());
+        std::iota(built.by_name.begin(), built.by_name.end(), 0);
+        std::ranges::sort(built.by_name, {}, [&](uint32_t node) { return names[node]; });
+
+        chars = built.chars;
+        name_ends = built.name_ends;
+        offsets = built.offsets;
+        targets = built.targets;
+        by_name = built.by_name;
+        sort_topologically();
+        order = built.order;
+    }
+
+    // Uses a snapshot's arrays in place and keeps the mapping. Throws runtime_error unless they
+    // form a valid graph in topological order.
+    explicit PathFinder(aoc::Snapshot snapshot) : mapping(std::move(snapshot)) {
+        chars = mapping->section<char>(0);
+        name_ends = mapping->section<uint32_t>(1);
+        offsets = mapping->section<uint32_t>(2);
+        targets = mapping->section<uint32_t>(3);
+        order = mapping->section<uint32_t>(4);
+        by_name = mapping->section<uint32_t>(5);
+        validate();
+    }
 
-        return accumulate(
-            devices[dest].begin(), devices[dest].end(), 0,
-            [this](uint32_t sum, std::string device) { return sum + search(device); });
+    // The spans point into `built`, which a copy would not share.
+    PathFinder(PathFinder const&) = delete;
+    PathFinder& operator=(PathFinder const&) = delete;
+    PathFinder(PathFinder&&) = default;
+    PathFinder& operator=(PathFinder&&) = default;
+
+    // Snapshot layout: chars, name_ends, offsets, targets, order, by_name.
+    void save(aoc::SnapshotWriter& writer) const {
+        writer.add<char>(chars);
+        writer.add<uint32_t>(name_ends);
+        writer.add<uint32_t>(offsets);
+        writer.add<uint32_t>(targets);
+        writer.add<uint32_t>(order);
+        writer.add<uint32_t>(by_name);
+    }
+
+    uint64_t search(std::string const& dest) { return count_paths(dest, "out"); }
+
+    // Number of distinct paths from `from` to `to`.
+    uint64_t count_paths(std::string const& from, std::string const& to) const {
+        auto source = find(from);
+        auto target = find(to);
+        if (!source || !target) {
+            return 0;
+        }
+        return paths_to(*target)[*source];
     }
 
-    uint64_t cached(std::string const& dest, std::array<std::string, 2> specials) {
-        std::unordered_map<std::string, uint64_t> cache;
-        std::vector<std::string> visited;
-        return search2(dest, specials, visited, cache);
+    // Paths from `from` to `to` through every waypoint, one count per waypoint subset per node.
+    // O(edges * 2^k) time, O(reachable nodes * 2^k) memory.
+    uint64_t count_paths_through(std::string const& from,
+                                 std::span<std::string const> waypoints,
+                                 std::string const& to = "out") const {
+        if (waypoints.size() > max_waypoints) {
+            throw std::invalid_argument("too many waypoints");
+        }
+        auto source = find(from);
+        auto target = find(to);
+        if (!source || !target) {
+            return 0;
+        }
+        std::vector<uint32_t> waypoint_bit(size(), 0);
+        for (size_t i = 0; i < waypoints.size(); i++) {
+            auto waypoint = find(waypoints[i]);
+            if (!waypoint) {
+                return 0;
+            }
+            waypoint_bit[*waypoint] |= 1u << i;
+        }
+
+        std::vector<uint32_t> slot = reachable_from(*source);
+        const size_t num_masks = size_t{1} << waypoints.size();
+        const uint32_t all = static_cast<uint32_t>(num_masks - 1);
+        std::vector<uint64_t> counts(
+            std::ranges::count_if(slot, [](uint32_t s) { return s != unreachable; }) * num_masks,
+            0);
+
+        for (uint32_t node : order | std::views::reverse) {
+            if (slot[node] == unreachable) {
+                continue;
+            }
+            uint64_t* block = counts.data() + slot[node] * num_masks;
+            if (node == *target) {
+                block[waypoint_bit[node]] = 1;
+                continue;
+            }
+            for (uint32_t next : outputs(node)) {
+                const uint64_t* from_next = counts.data() + slot[next] * num_masks;
+                for (size_t mask = 0; mask < num_masks; mask++) {
+                    block[mask] += from_next[mask];
+                }
+            }
+            absorb_waypoints({block, num_masks}, waypoint_bit[node]);
+        }
+        return counts[slot[*source] * num_masks + all];
     }
 
+    static constexpr size_t max_waypoints = 16;
+
    private:
-    std::string build_key(std::string_view dest, std::vector<std::string> const& visited) {
-        return std::format("{}{}", dest, std::ranges::fold_left(visited, "", std::plus{}));
+    friend struct LivePaths;
+    friend struct PathQueries;
+
+    size_t size() const { return name_ends.size(); }
+
+    std::string_view name(uint32_t node) const {
+        const uint32_t start = node == 0 ? 0 : name_ends[node - 1];
+        return {chars.data() + start, name_ends[node] - start};
     }
 
-    uint64_t search2(std::string const& dest,
-                     std::array<std::string, 2> const& specials,
-                     std::vector<std::string> const& visited,
-                     std::unordered_map<std::string, uint64_t>& cache) {
-        std::string key = build_key(dest, visited);
-        auto it = cache.find(key);
-        if (it != cache.end()) {
-            return it->second;
+    // The node called `wanted`, found by binary search over the name index.
+    std::optional<uint32_t> find(std::string_view wanted) const {
+        auto it = std::ranges::lower_bound(by_name, wanted, {},
+                                           [this](uint32_t node) { return name(node); });
+        if (it == by_name.end() || name(*it) != wanted) {
+            return std::nullopt;
+        }
+        return *it;
+    }
+
+    // Paths from every node to `target`.
+    std::vector<uint64_t> paths_to(uint32_t target) const {
+        std::vector<uint64_t> paths(size(), 0);
+        paths[target] = 1;
+        for (uint32_t node : order | std::views::reverse) {
+            if (node == target) {
+                continue;
+            }
+            for (uint32_t next : outputs(node)) {
+                paths[node] += paths[next];
+            }
+        }
+        return paths;
+    }
+
+    static constexpr uint32_t unreachable = std::numeric_limits<uint32_t>::max();
+
+    // Dense slot for every node reachable from `source`, unreachable for the rest.
+    std::vector<uint32_t> reachable_from(uint32_t source) const {
+        std::vector<uint32_t> slot(size(), unreachable);
+        std::vector<uint32_t> stack{source};
+        uint32_t next_slot = 0;
+        slot[source] = next_slot++;
+        while (!stack.empty()) {
+            uint32_t node = stack.back();
+            stack.pop_back();
+            for (uint32_t next : outputs(node)) {
+                if (slot[next] == unreachable) {
+                    slot[next] = next_slot++;
+                    stack.push_back(next);
+                }
+            }
+        }
+        return slot;
+    }
+
+    void validate() const {
+        auto fail = [] { throw std::runtime_error("snapshot does not hold a device graph"); };
+        if (!std::ranges::is_sorted(name_ends) ||
+            (!name_ends.empty() && name_ends.back() > chars.size()) ||
+            by_name.size() != size() || order.size() != size() ||
+            offsets.size() != size() + 1 || offsets.front() != 0 ||
+            offsets.back() != targets.size() || !std::ranges::is_sorted(offsets)) {
+            fail();
+        }
+        for (size_t i = 0; i < by_name.size(); i++) {
+            if (by_name[i] >= size() || (i > 0 && name(by_name[i - 1]) >= name(by_name[i]))) {
+                fail();
+            }
+        }
+        std::vector<uint32_t> position(size(), unreachable);
+        for (uint32_t i = 0; i < order.size(); i++) {
+            if (order[i] >= size() || position[order[i]] != unreachable) {
+                fail();
+            }
+            position[order[i]] = i;
         }
-        if (dest == "out") {
-            bool found = std::all_of(specials.begin(), specials.end(), [&visited](std::string s) {
-                return std::find(visited.begin(), visited.end(), s) != visited.end();
-            });
-            return found ? 1 : 0;
+        for (uint32_t node = 0; node < size(); node++) {
+            for (uint32_t next : outputs(node)) {
+                if (next >= size() || position[next] <= position[node]) {
+                    fail();
+                }
+            }
         }
+    }
+
+    std::span<uint32_t const> outputs(uint32_t node) const {
+        return targets.subspan(offsets[node], offsets[node + 1] - offsets[node]);
+    }
 
-        uint64_t sum = 0;
-        for (auto device : devices[dest]) {
-            auto new_visited = visited;
-            if (std::find(specials.begin(), specials.end(), device) != specials.end()) {
-                new_visited.push_back(device);
+    // Kahn's algorithm; the device graph must be acyclic for path counts to be finite.
+    void sort_topologically() {
+        std::vector<uint32_t> incoming(size(), 0);
+        for (uint32_t target : targets) {
+            incoming[target]++;
+        }
+        auto& sorted = built.order;
+        sorted.clear();
+        for (uint32_t node = 0; node < size(); node++) {
+            if (incoming[node] == 0) {
+                sorted.push_back(node);
+            }
+        }
+        for (size_t i = 0; i < sorted.size(); i++) {
+            for (uint32_t next : outputs(sorted[i])) {
+                if (--incoming[next] == 0) {
+                    sorted.push_back(next);
+                }
             }
-            sum += search2(device, specials, new_visited, cache);
         }
-        cache[key] = sum;
-        return sum;
+        if (sorted.size() != size()) {
+            throw std::runtime_error("device graph contains a cycle");
+        }
     }
 
-    std::unordered_map<std::string, std::vector<std::string>> devices;
+    // The spans point into `built` or into `mapping`.
+    struct Arrays {
+        std::vector<char> chars;
+        std::vector<uint32_t> name_ends;
+        std::vector<uint32_t> offsets;
+        std::vector<uint32_t> targets;
+        std::vector<uint32_t> order;
+        std::vector<uint32_t> by_name;
+    };
+    Arrays built;
+    std::optional<aoc::Snapshot> mapping;
+
+    std::span<char const> chars;
+    std::span<uint32_t const> name_ends;
+    std::span<uint32_t const> offsets;
+    std::span<uint32_t const> targets;
+    std::span<uint32_t const> order;
+    std::span<uint32_t const> by_name;
 };
 
-int main() {
-    std::ifstream input("puzzle.txt");
-    std::string line;
-    std::unordered_map<std::string, std::vector<std::string>> devices;
+// Path counts towards one destination, kept current while edges are added and removed. Edits
+// propagate to ancestors only; ranks are repaired with Pearce-Kelly.
+struct LivePaths {
+    LivePaths() = delete;
+    LivePaths(PathFinder const& finder,
+              std::string const& to = "out",
+              std::span<std::string const> waypoints = {})
+        : successors(finder.size()),
+          predecessors(finder.size()),
+          rank(finder.size()),
+          waypoint_bit(finder.size(), 0),
+          visited(finder.size(), false),
+          num_masks(masks_for(waypoints.size())) {
+        for (uint32_t node = 0; node < finder.size(); node++) {
+            names.emplace_back(finder.name(node));
+            ids.emplace(names.back(), node);
+        }
+        for (uint32_t node = 0; node < names.size(); node++) {
+            for (uint32_t next : finder.outputs(node)) {
+                successors[node].push_back(next);
+                predecessors[next].push_back(node);
+            }
+        }
+        for (uint32_t i = 0; i < finder.order.size(); i++) {
+            rank[finder.order[i]] = i;
+        }
+        destination = intern(to);
+        for (size_t i = 0; i < waypoints.size(); i++) {
+            waypoint_bit[intern(waypoints[i])] |= 1u << i;
+        }
+
+        // Paths end at the destination, whatever leaves it.
+        counts.assign(names.size() * num_masks, 0);
+        block(destination)[waypoint_bit[destination]] = 1;
+        for (uint32_t node : finder.order | std::views::reverse) {
+            std::span<uint64_t> counts_here = block(node);
+            if (node == destination) {
+                continue;
+            }
+            for (uint32_t next : successors[node]) {
+                std::ranges::transform(counts_here, block(next), counts_here.begin(), std::plus{});
+            }
+            absorb_waypoints(counts_here, waypoint_bit[node]);
+        }
+    }
+
+    // Every path from `from` to the destination.
+    uint64_t paths(std::string const& from) const {
+        auto it = ids.find(from);
+        return it == ids.end() ? 0 : std::ranges::fold_left(block(it->second), 0ull, std::plus{});
+    }
+
+    // Paths from `from` to the destination through every waypoint.
+    uint64_t paths_through(std::string const& from) const {
+        auto it = ids.find(from);
+        return it == ids.end() ? 0 : block(it->second)[num_masks - 1];
+    }
+
+    // False, changing nothing, if the edge would close a cycle. Unknown devices are created.
+    bool add_edge(std::string const& from, std::string const& to) {
+        const uint32_t source = intern(from);
+        const uint32_t target = intern(to);
+        if (source == target || (rank[source] > rank[target] && !reorder(source, target))) {
+            return false;
+        }
+        successors[source].push_back(target);
+        predecessors[target].push_back(source);
+        propagate(source, std::vector<uint64_t>(block(target).begin(), block(target).end()));
+        return true;
+    }
+
+    // Removes one copy of the edge; false if there is none.
+    bool remove_edge(std::string const& from, std::string const& to) {
+        auto source = ids.find(from);
+        auto target = ids.find(to);
+        if (source == ids.end() || target == ids.end()) {
+            return false;
+        }
+        auto& outgoing = successors[source->second];
+        auto edge = std::ranges::find(outgoing, target->second);
+        if (edge == outgoing.end()) {
+            return false;
+        }
+        outgoing.erase(edge);
+        auto& incoming = predecessors[target->second];
+        incoming.erase(std::ranges::find(incoming, source->second));
+
+        std::vector<uint64_t> delta(num_masks);
+        std::ranges::transform(block(target->second), delta.begin(), std::negate{});
+        propagate(source->second, std::move(delta));
+        return true;
+    }
+
+   private:
+    // 2^k waypoint subsets, checked before shifting by k.
+    static size_t masks_for(size_t num_waypoints) {
+        if (num_waypoints > PathFinder::max_waypoints) {
+            throw std::invalid_argument("too many waypoints");
+        }
+        return size_t{1} << num_waypoints;
+    }
+
+    std::span<uint64_t> block(uint32_t node) {
+        return std::span{counts}.subspan(size_t{node} * num_masks, num_masks);
+    }
 
-    while (std::getline(input, line)) {
-        auto pos = line.find(':');
-        std::string name = line.substr(0, pos);
-        std::string rest = line.substr(pos + 2);
-        std::vector<std::string> dests =
-            rest | std::views::split(' ') | std::ranges::to<std::vector<std::string>>();
-        devices[name] = dests;
+    std::span<uint64_t const> block(uint32_t node) const {
+        return std::span{counts}.subspan(size_t{node} * num_masks, num_masks);
     }
 
-    PathFinder finder(devices);
-    std::cout << finder.search("you") << std::endl;
+    uint32_t intern(std::string const& name) {
+        auto [it, inserted] = ids.try_emplace(name, static_cast<uint32_t>(names.size()));
+        if (inserted) {
+            names.push_back(name);
+            successors.emplace_back();
+            predecessors.emplace_back();
+            rank.push_back(it->second);
+            waypoint_bit.push_back(0);
+            visited.push_back(false);
+            counts.resize(counts.size() + num_masks, 0);
+        }
+        return it->second;
+    }
 
-    std::array<std::string, 2> specials = {"dac", "fft"};
-    std::cout << finder.cached("svr", specials) << std::endl;
+    // Adds `delta` to `start` and its ancestors in decreasing rank. Counts wrap modulo 2^64.
+    void propagate(uint32_t start, std::vector<uint64_t> delta) {
+        std::unordered_map<uint32_t, std::vector<uint64_t>> pending;
+        std::priority_queue<std::pair<uint32_t, uint32_t>> ready;
+        pending.emplace(start, std::move(delta));
+        ready.emplace(rank[start], start);
+        while (!ready.empty()) {
+            const uint32_t node = ready.top().second;
+            ready.pop();
+            auto change = std::move(pending.extract(node).mapped());
+            if (node == destination) {
+                continue;
+            }
+            absorb_waypoints(change, waypoint_bit[node]);
+            std::ranges::transform(block(node), change, block(node).begin(), std::plus{});
+            for (uint32_t previous : predecessors[node]) {
+                auto [it, inserted] = pending.try_emplace(previous, num_masks, 0);
+                if (inserted) {
+                    ready.emplace(rank[previous], previous);
+                }
+                std::ranges::transform(it->second, change, it->second.begin(), std::plus{});
+            }
+        }
+    }
+
+    // Reranks for from -> to when `to` ranks before `from`; false if the edge closes a cycle.
+    bool reorder(uint32_t from, uint32_t to) {
+        auto collect = [&](uint32_t start, auto const& edges, auto const& inside) {
+            std::vector<uint32_t> found{start};
+            visited[start] = true;
+            for (size_t i = 0; i < found.size(); i++) {
+                for (uint32_t next : edges[found[i]]) {
+                    if (!visited[next] && inside(next)) {
+                        visited[next] = true;
+                        found.push_back(next);
+                    }
+                }
+            }
+            return found;
+        };
+
+        auto forward = collect(to, successors, [&](uint32_t n) { return rank[n] <= rank[from]; });
+        const bool cycle = visited[from];
+        std::vector<uint32_t> backward;
+        if (!cycle) {
+            backward = collect(from, predecessors, [&](uint32_t n) { return rank[n] > rank[to]; });
+        }
+        for (uint32_t node : forward) {
+            visited[node] = false;
+        }
+        for (uint32_t node : backward) {
+            visited[node] = false;
+        }
+        if (cycle) {
+            return false;
+        }
+
+        auto by_rank = [&](uint32_t a, uint32_t b) { return rank[a] < rank[b]; };
+        std::ranges::sort(forward, by_rank);
+        std::ranges::sort(backward, by_rank);
+        std::vector<uint32_t> slots;
+        for (uint32_t node : backward) {
+            slots.push_back(rank[node]);
+        }
+        for (uint32_t node : forward) {
+            slots.push_back(rank[node]);
+        }
+        std::ranges::sort(slots);
+        size_t next_slot = 0;
+        for (uint32_t node : backward) {
+            rank[node] = slots[next_slot++];
+        }
+        for (uint32_t node : forward) {
+            rank[node] = slots[next_slot++];
+        }
+        return true;
+    }
+
+    std::vector<std::string> names;
+    std::unordered_map<std::string, uint32_t> ids;
+    std::vector<std::vector<uint32_t>> successors;
+    std::vector<std::vector<uint32_t>> predecessors;
+    std::vector<uint32_t> rank;
+    std::vector<uint32_t> waypoint_bit;
+    std::vector<bool> visited;
+    uint32_t destination = 0;
+    size_t num_masks;
+    std::vector<uint64_t> counts;
+};
+
+// Fixed-capacity LRU map. The capacity must be at least one.
+template <typename Key, typename Value, typename Hash = std::hash<Key>>
+class LruCache {
+   public:
+    explicit LruCache(size_t capacity) : capacity(capacity) {
+        if (capacity == 0) {
+            throw std::invalid_argument("cache capacity must be at least 1");
+        }
+    }
+
+    Value const* find(Key const& key) {
+        auto it = index.find(key);
+        if (it == index.end()) {
+            return nullptr;
+        }
+        entries.splice(entries.begin(), entries, it->second);
+        return &it->second->second;
+    }
+
+    Value const& insert(Key const& key, Value value) {
+        if (auto it = index.find(key); it != index.end()) {
+            entries.erase(it->second);
+            index.erase(it);
+        }
+        entries.emplace_front(key, std::move(value));
+        index[key] = entries.begin();
+        if (entries.size() > capacity) {
+            index.erase(entries.back().first);
+            entries.pop_back();
+        }
+        return entries.front().second;
+    }
+
+   private:
+    size_t capacity;
+    std::list<std::pair<Key, Value>> entries;
+    std::unordered_map<Key, typename std::list<std::pair<Key, Value>>::iterator, Hash> index;
+};
+
+struct IdsHash {
+    size_t operator()(std::vector<uint32_t> const& ids) const {
+        return std::ranges::fold_left(ids, ids.size(), [](size_t seed, uint32_t id) {
+            return seed ^ (id + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2));
+        });
+    }
+};
+
+// Retained tables and memoised answers for PathQueries, each at least 1.
+struct PathQueryOptions {
+    size_t max_tables = 64;
+    size_t max_answers = 4096;
+};
+
+// Path-count queries against one fixed device graph. A must-visit count is the product of
+// plain counts between consecutive stops in topological order, read from cached tables.
+struct PathQueries {
+    struct Query {
+        std::string from;
+        std::string to = "out";
+        std::vector<std::string> waypoints;
+    };
+
+    PathQueries() = delete;
+    explicit PathQueries(PathFinder const& finder, PathQueryOptions options = {})
+        : finder(finder), rank(finder.size()), tables(options.max_tables),
+          answers(options.max_answers) {
+        for (uint32_t i = 0; i < finder.order.size(); i++) {
+            rank[finder.order[i]] = i;
+        }
+    }
+
+    uint64_t count(Query const& query) {
+        auto stops = route(query);
+        if (!stops) {
+            return 0;
+        }
+        if (auto const* answer = answers.find(*stops)) {
+            return *answer;
+        }
+        uint64_t paths = 1;
+        for (size_t i = 0; i + 1 < stops->size() && paths != 0; i++) {
+            paths *= table((*stops)[i + 1])[(*stops)[i]];
+        }
+        return answers.insert(*stops, paths);
+    }
+
+    // Builds each table the batch needs once, then answers.
+    std::vector<uint64_t> count(std::span<Query const> queries) {
+        std::vector<uint32_t> targets;
+        for (auto const& query : queries) {
+            if (auto stops = route(query); stops && !answers.find(*stops)) {
+                targets.insert(targets.end(), stops->begin() + 1, stops->end());
+            }
+        }
+        std::ranges::sort(targets);
+        targets.erase(std::ranges::unique(targets).begin(), targets.end());
+        for (uint32_t target : targets) {
+            table(target);
+        }
+        return queries |
+               std::views::transform([this](Query const& query) { return count(query); }) |
+               std::ranges::to<std::vector<uint64_t>>();
+    }
+
+   private:
+    // Source, waypoints in topological order and destination, or nothing if any is unknown.
+    std::optional<std::vector<uint32_t>> route(Query const& query) const {
+        std::vector<uint32_t> stops;
+        for (auto const& name : query.waypoints) {
+            auto stop = finder.find(name);
+            if (!stop) {
+                return std::nullopt;
+            }
+            stops.push_back(*stop);
+        }
+        std::ranges::sort(stops, {}, [this](uint32_t node) { return rank[node]; });
+        stops.erase(std::ranges::unique(stops).begin(), stops.end());
+
+        auto source = finder.find(query.from);
+        auto target = finder.find(query.to);
+        if (!source || !target) {
+            return std::nullopt;
+        }
+        stops.insert(stops.begin(), *source);
+        stops.push_back(*target);
+        return stops;
+    }
+
+    std::vector<uint64_t> const& table(uint32_t target) {
+        if (auto const* paths = tables.find(target)) {
+            return *paths;
+        }
+        return tables.insert(target, finder.paths_to(target));
+    }
+
+    PathFinder const& finder;
+    std::vector<uint32_t> rank;
+    LruCache<uint32_t, std::vector<uint64_t>> tables;
+    LruCache<std::vector<uint32_t>, uint64_t, IdsHash> answers;
+};
+
+#ifdef AOC_SELF_TEST
+using Devices = std::unordered_map<std::string, std::vector<std::string>>;
+
+std::string device_name(uint32_t node, uint32_t size) {
+    return node + 1 == size ? "out" : "d" + std::to_string(node);
+}
+
+// Random DAG of `size` devices, the last named "out". Every device is listed.
+Devices random_devices(std::mt19937& rng, uint32_t size, uint32_t fanout) {
+    Devices devices;
+    for (uint32_t node = 0; node < size; node++) {
+        auto& outputs = devices[device_name(node, size)];
+        for (uint32_t i = 0; i < fanout; i++) {
+            const uint32_t next = node + 1 + rng() % 4;
+            if (next < size) {
+                outputs.push_back(device_name(next, size));
+            }
+        }
+    }
+    return devices;
+}
+
+// Random edits to a LivePaths, checked against a PathFinder rebuilt after each.
+bool check_live_paths(std::mt19937& rng) {
+    constexpr uint32_t size = 24;
+    for (int trial = 0; trial < 20; trial++) {
+        Devices devices = random_devices(rng, size, 3);
+        std::array<std::string, 2> waypoints = {device_name(rng() % size, size),
+                                                device_name(rng() % size, size)};
+        LivePaths live(PathFinder(devices), "out", waypoints);
+        for (int edit = 0; edit < 200; edit++) {
+            const std::string from = device_name(rng() % size, size);
+            const std::string to = device_name(rng() % size, size);
+            auto& outputs = devices[from];
+            if (rng() % 2) {
+                outputs.push_back(to);
+                if (!live.add_edge(from, to)) {
+                    try {
+                        PathFinder{devices};
+                        std::cerr << "LivePaths rejected " << from << " -> " << to << std::endl;
+                        return false;
+                    } catch (std::runtime_error const&) {
+                        outputs.pop_back();
+                    }
+                }
+            } else {
+                auto edge = std::ranges::find(outputs, to);
+                if (live.remove_edge(from, to) != (edge != outputs.end())) {
+                    std::cerr << "LivePaths removed " << from << " -> " << to << std::endl;
+                    return false;
+                }
+                if (edge != outputs.end()) {
+                    outputs.erase(edge);
+                }
+            }
+
+            const PathFinder rebuilt(devices);
+            for (uint32_t node = 0; node < size; node++) {
+                const std::string name = device_name(node, size);
+                if (live.paths(name) != rebuilt.count_paths(name, "out") ||
+                    live.paths_through(name) != rebuilt.count_paths_through(name, waypoints)) {
+                    std::cerr << "LivePaths disagrees at " << name << " after edit " << edit
+                              << std::endl;
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+// PathQueries against count_paths_through, with caches small enough to evict.
+bool check_path_queries(std::mt19937& rng) {
+    constexpr uint32_t size = 24;
+    for (PathQueryOptions options : {PathQueryOptions{1, 1}, PathQueryOptions{2, 3}}) {
+        for (int trial = 0; trial < 20; trial++) {
+            const PathFinder finder(random_devices(rng, size, 3));
+            PathQueries queries(finder, options);
+            std::vector<PathQueries::Query> batch(50);
+            for (auto& query : batch) {
+                query.from = device_name(rng() % size, size);
+                query.to = device_name(rng() % size, size);
+                for (uint32_t i = rng() % 4; i > 0; i--) {
+                    query.waypoints.push_back(device_name(rng() % size, size));
+                }
+            }
+            const std::vector<uint64_t> answers = queries.count(batch);
+            for (size_t i = 0; i < batch.size(); i++) {
+                auto const& query = batch[i];
+                const uint64_t expected =
+                    finder.count_paths_through(query.from, query.waypoints, query.to);
+                if (answers[i] != expected || queries.count(query) != expected) {
+                    std::cerr << "PathQueries disagrees from " << query.from << " to "
+                              << query.to << std::endl;
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+bool self_test() {
+    std::mt19937 rng(2025);
+    return check_live_paths(rng) && check_path_queries(rng);
+}
+#endif
+
+int main() {
+#ifdef AOC_SELF_TEST
+    if (!self_test()) {
+        return 1;
+    }
+#endif
+    constexpr uint32_t schema = 2;
+    std::ifstream input("puzzle.txt");
+    const std::string text = aoc::read_all(input);
+    const uint64_t hash = aoc::hash_bytes(text);
+
+    auto load = [&] {
+        if (auto snapshot = aoc::Snapshot::open("puzzle.txt.snapshot", schema, hash)) {
+            try {
+                return PathFinder(std::move(*snapshot));
+            } catch (std::runtime_error const&) {
+                // Rebuilt and rewritten below.
+            }
+        }
+        std::unordered_map<std::string, std::vector<std::string>> devices;
+        for (aoc::Scanner scanner{text}; !scanner.done();) {
+            std::string_view line = scanner.line();
+            auto pos = line.find(':');
+            std::string name{line.substr(0, pos)};
+            std::string_view rest = line.substr(pos + 2);
+            std::vector<std::string> dests =
+                rest | std::views::split(' ') | std::ranges::to<std::vector<std::string>>();
+            devices[name] = dests;
+        }
+        PathFinder parsed(devices);
+        aoc::SnapshotWriter writer;
+        parsed.save(writer);
+        writer.write("puzzle.txt.snapshot", schema, hash);
+        return parsed;
+    };
+    PathFinder finder = load();
+    uint64_t answer1 = 0;
+    uint64_t answer2 = 0;
+    {
+        aoc::Phase phase{"part1"};
+        answer1 = finder.search("you");
+    }
+    {
+        aoc::Phase phase{"part2"};
+        std::array<std::string, 2> specials = {"dac", "fft"};
+        answer2 = finder.count_paths_through("svr", specials);
+    }
+    std::cout << answer1 << std::endl;
+    std::cout << answer2 << std::endl;
     return 0;
 }
@@ -1,30 +1,28 @@
+#include <array>
+#include <charconv>
 #include <fstream>
 #include <iostream>
-#include <sstream>
+#include <iterator>
+#include <limits>
 #include <string>
 #include <vector>
 
-std::string repeat(std::string_view text, size_t times) {
-    std::string result;
-    result.reserve(text.length() * times);
-    for (size_t i = 0; i < times; i++) {
-        result += text;
-    }
-    return result;
-}
+#include "../common/memory.h"
+#include "../common/parse.h"
 
 bool is_valid(std::string_view text) {
     size_t mid = text.length() / 2;
     return text.substr(0, mid) == text.substr(mid);
 }
 
+// n copies of a prefix exactly when the string equals itself shifted by len / n.
 bool is_valid2(std::string_view text) {
-    std::vector<int> primes{2, 3, 5, 7};
+    static constexpr std::array<size_t, 4> primes{2, 3, 5, 7};
     for (auto const& n : primes) {
         size_t len = text.length();
         if (len % n == 0) {
-            std::string_view piece = text.substr(0, len / n);
-            if (repeat(piece, n).compare(text) == 0) {
+            size_t period = len / n;
+            if (text.substr(period) == text.substr(0, len - period)) {
                 return true;
             }
         }
@@ -34,17 +32,19 @@ bool is_valid2(std::string_view text) {
 
 using Test = bool (*)(std::string_view);
 
-uint64_t part1(const std::string line, Test test) {
-    std::istringstream iss(line);
-    std::string currentItem;
+uint64_t part1(std::string_view line, Test test) {
+    aoc::Scanner scanner{line};
     uint64_t total{0};
-    while (std::getline(iss, currentItem, ',')) {
-        size_t pos = currentItem.find("-");
-        uint64_t start = std::stoull(currentItem.substr(0, pos));
-        uint64_t end = std::stoull(currentItem.substr(pos + 1));
+    while (!scanner.done()) {
+        uint64_t start = scanner.number<uint64_t>();
+        scanner.expect('-');
+        uint64_t end = scanner.number<uint64_t>();
+        scanner.consume(',');
 
         for (uint64_t i = start; i <= end; i++) {
-            if (test(std::to_string(i))) {
+            char digits[std::numeric_limits<uint64_t>::digits10 + 1];
+            auto [last, error] = std::to_chars(std::begin(digits), std::end(digits), i);
+            if (test(std::string_view(digits, last))) {
                 total += i;
             }
         }
@@ -56,7 +56,17 @@ int main() {
     std::ifstream puzzle("puzzle.txt");
     std::string line;
     std::getline(puzzle, line);
-    std::cout << part1(line, is_valid) << std::endl;
-    std::cout << part1(line, is_valid2) << std::endl;
+    uint64_t answer1 = 0;
+    uint64_t answer2 = 0;
+    {
+        aoc::Phase phase{"part1"};
+        answer1 = part1(line, is_valid);
+    }
+    {
+        aoc::Phase phase{"part2"};
+        answer2 = part1(line, is_valid2);
+    }
+    std::cout << answer1 << std::endl;
+    std::cout << answer2 << std::endl;
     return 0;
 }
@@ -1,15 +1,25 @@
+#include <algorithm>
 #include <fstream>
 #include <iostream>
 #include <numeric>
+#include <span>
 #include <string>
+#include <string_view>
+#include <utility>
 #include <vector>
 
-std::tuple<size_t, size_t> find_max(const std::vector<unsigned>& digits, size_t start, size_t end) {
+#include "../common/memory.h"
+#include "../common/parse.h"
+#include "../common/pipeline.h"
+
+constexpr std::tuple<size_t, size_t> find_max(std::span<const unsigned> digits,
+                                              size_t start,
+                                              size_t end) {
     auto max_it = std::max_element(digits.begin() + start, digits.begin() + end);
     return {max_it - digits.begin(), *max_it};
 }
 
-size_t calculate_joltage(const std::vector<unsigned>& digits, int block_size) {
+constexpr size_t calculate_joltage(std::span<const unsigned> digits, int block_size) {
     size_t index{0};
     size_t joltage{0};
     for (size_t i = 0; i < block_size; ++i) {
@@ -20,32 +30,69 @@ size_t calculate_joltage(const std::vector<unsigned>& digits, int block_size) {
     return joltage;
 }
 
-size_t part1(const std::vector<std::vector<unsigned>>& arr) {
+constexpr size_t part1(const std::vector<std::vector<unsigned>>& arr) {
     return std::accumulate(arr.begin(), arr.end(), 0, [](size_t acc, const auto& digits) {
         return acc + calculate_joltage(digits, 2);
     });
 }
 
-size_t part2(const std::vector<std::vector<unsigned>>& arr) {
+constexpr size_t part2(const std::vector<std::vector<unsigned>>& arr) {
     return std::accumulate(arr.begin(), arr.end(), 0l, [](size_t acc, const auto& digits) {
         return acc + calculate_joltage(digits, 12);
     });
 }
 
-int main() {
-    std::ifstream puzzle("puzzle.txt");
-    std::string line;
+constexpr std::vector<std::vector<unsigned>> parse(std::string_view text) {
     std::vector<std::vector<unsigned>> arr{};
-
-    while (std::getline(puzzle, line)) {
-        std::vector<unsigned> digits{};
+    for (aoc::Scanner scanner{text}; !scanner.done();) {
+        std::string_view line = scanner.line();
+        std::vector<unsigned> digits(line.length());
         for (int i = 0; i < line.length(); i++) {
-            digits.push_back(line[i] - '0');
+            digits[i] = line[i] - '0';
         }
-        arr.push_back(digits);
+        arr.push_back(std::move(digits));
+    }
+    return arr;
+}
+
+#ifdef AOC_EMBED_INPUT
+#define AOC_EMBED_FILE "../day3/puzzle.txt"
+#define AOC_EMBED_XXD "../day3/puzzle.txt.inc"
+#include "../common/embed.h"
+
+constexpr auto answers = [] {
+    const auto arr = parse(aoc::embedded_input);
+    return std::pair{part1(arr), part2(arr)};
+}();
+
+int main() {
+    std::cout << answers.first << std::endl;
+    std::cout << answers.second << std::endl;
+    return 0;
+}
+#else
+int main() {
+    std::ifstream puzzle("puzzle.txt");
+    if (!puzzle) {
+        std::cerr << "Error opening file" << std::endl;
+        return 1;
+    }
+    std::pair<size_t, size_t> answers;
+    {
+        aoc::Phase phase{"solve"};
+        answers = aoc::pipeline(
+            puzzle, std::pair<size_t, size_t>{}, parse,
+            [](std::vector<std::vector<unsigned>> const& arr) {
+                return std::pair{part1(arr), part2(arr)};
+            },
+            [](std::pair<size_t, size_t> total, std::pair<size_t, size_t> block) {
+                return std::pair{total.first + block.first, total.second + block.second};
+            });
     }
+    const auto [answer1, answer2] = answers;
 
-    std::cout << part1(arr) << std::endl;
-    std::cout << part2(arr) << std::endl;
+    std::cout << answer1 << std::endl;
+    std::cout << answer2 << std::endl;
     return 0;
 }
+#endif
@@ -1,9 +1,16 @@
 #include <algorithm>
+#include <array>
 #include <fstream>
 #include <iostream>
+#include <memory_resource>
 #include <string>
 #include <vector>
 
+#include "../common/memory.h"
+#include "../common/parse.h"
+
+using Grid = std::pmr::vector<std::pmr::string>;
+
 struct Position {
     int x;
     int y;
@@ -14,10 +21,10 @@ struct Dimensions {
     size_t width;
 };
 
-int neighbours(std::vector<std::string> const& lines, Dimensions const& dim, Position const&& pos) {
-    static const std::vector<Position> deltas = {
+int neighbours(Grid const& lines, Dimensions const& dim, Position const&& pos) {
+    static constexpr std::array<Position, 8> deltas = {{
         {-1, -1}, {-1, 0}, {-1, 1}, {0, -1}, {0, 1}, {1, -1}, {1, 0}, {1, 1},
-    };
+    }};
     int count{0};
     std::for_each(deltas.begin(), deltas.end(), [&](Position delta) {
         Position new_pos = {pos.x + delta.x, pos.y + delta.y};
@@ -30,7 +37,7 @@ int neighbours(std::vector<std::string> const& lines, Dimensions const& dim, Pos
     return count;
 }
 
-int part1(std::vector<std::string>& lines, Dimensions const& dim) {
+int part1(Grid& lines, Dimensions const& dim) {
     int count{0};
     for (int i = 0; i < dim.height; i++) {
         for (int j = 0; j < dim.width; j++) {
@@ -43,8 +50,9 @@ int part1(std::vector<std::string>& lines, Dimensions const& dim) {
     return count;
 }
 
-int update(std::vector<std::string>& lines, Dimensions const& dim) {
-    const std::vector<std::string> copy = lines;
+// `copy` keeps its buffers between rounds, so only the first round allocates.
+int update(Grid& lines, Grid& copy, Dimensions const& dim) {
+    copy = lines;
     int count{0};
     for (int i = 0; i < dim.height; i++) {
         for (int j = 0; j < dim.width; j++) {
@@ -60,11 +68,12 @@ int update(std::vector<std::string>& lines, Dimensions const& dim) {
     return count;
 }
 
-int part2(std::vector<std::string>& lines, Dimensions const& dim) {
-    int count = update(lines, dim);
+int part2(Grid& lines, Dimensions const& dim) {
+    Grid copy{lines.get_allocator()};
+    int count = update(lines, copy, dim);
     int prev = count;
     while (true) {
-        count += update(lines, dim);
+        count += update(lines, copy, dim);
         if (count == prev) {
             break;
         }
@@ -75,17 +84,28 @@ int part2(std::vector<std::string>& lines, Dimensions const& dim) {
 
 int main() {
     std::ifstream file("puzzle.txt");
-    std::string line;
-    std::vector<std::string> lines;
-    while (std::getline(file, line)) {
-        lines.push_back(line);
+    const std::string text = aoc::read_all(file);
+    aoc::Arena arena;
+    Grid lines{arena.resource()};
+    for (aoc::Scanner scanner{text}; !scanner.done();) {
+        lines.emplace_back(scanner.line());
     }
 
     const size_t height = lines.size();
     const size_t width = lines[0].size();
     const Dimensions dim = {height, width};
-    std::cout << part1(lines, dim) << std::endl;
-    std::cout << part2(lines, dim) << std::endl;
+    int answer1 = 0;
+    int answer2 = 0;
+    {
+        aoc::Phase phase{"part1", arena};
+        answer1 = part1(lines, dim);
+    }
+    {
+        aoc::Phase phase{"part2", arena};
+        answer2 = part2(lines, dim);
+    }
+    std::cout << answer1 << std::endl;
+    std::cout << answer2 << std::endl;
 
     return 0;
 }
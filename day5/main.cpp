@@ -1,16 +1,27 @@
 #include <algorithm>
 #include <cstdint>
+#include <filesystem>
 #include <fstream>
+#include <iterator>
 #include <iostream>
+#include <span>
 #include <string>
+#include <string_view>
+#include <tuple>
+#include <utility>
 #include <vector>
 
+#include "../common/memory.h"
+#include "../common/parse.h"
+#include "../common/pipeline.h"
+#include "../common/snapshot.h"
+
 struct Range {
     std::uint64_t start;
     std::uint64_t end;
 };
 
-std::vector<Range> pack(const std::vector<Range>& ranges) {
+constexpr std::vector<Range> pack(std::span<const Range> ranges) {
     std::vector<Range> result{ranges[0]};
     for (size_t i = 1; i < ranges.size(); ++i) {
         Range previous = result.back();
@@ -35,7 +46,7 @@ std::vector<Range> pack(const std::vector<Range>& ranges) {
     return result;
 }
 
-int part1(const std::vector<Range>& ranges, const std::vector<std::uint64_t>& ids) {
+constexpr int part1(std::span<const Range> ranges, std::span<const std::uint64_t> ids) {
     int result = 0;
     for (const auto& id : ids) {
         for (const auto [start, end] : ranges) {
@@ -48,9 +59,23 @@ int part1(const std::vector<Range>& ranges, const std::vector<std::uint64_t>& id
     return result;
 }
 
-uint64_t part2(std::vector<Range>& ranges) {
+int count_fresh(std::span<const Range> packed, std::span<const std::uint64_t> ids) {
+    int result = 0;
+    for (const auto id : ids) {
+        auto after = std::upper_bound(packed.begin(), packed.end(), id,
+                                      [](std::uint64_t value, const Range& range) {
+                                          return value < range.start;
+                                      });
+        if (after != packed.begin() && id <= std::prev(after)->end) {
+            result++;
+        }
+    }
+    return result;
+}
+
+constexpr uint64_t part2(std::span<Range> ranges) {
     std::sort(ranges.begin(), ranges.end(), [](const Range& lhs, const Range& rhs) {
-        return std::tie(lhs.start, lhs.end) <= std::tie(rhs.start, rhs.end);
+        return std::tie(lhs.start, lhs.end) < std::tie(rhs.start, rhs.end);
     });
 
     uint64_t result = 0;
@@ -60,27 +85,116 @@ uint64_t part2(std::vector<Range>& ranges) {
     return result;
 }
 
-int main() {
-    std::ifstream input("puzzle.txt");
-    std::string line;
+struct Puzzle {
     std::vector<Range> ranges;
     std::vector<std::uint64_t> ids;
-    while (getline(input, line)) {
+};
+
+// A "start-end" range at the scanner, up to and including its line end.
+constexpr Range parse_range(aoc::Scanner& scanner) {
+    Range range{};
+    range.start = scanner.number<std::uint64_t>();
+    scanner.expect('-');
+    range.end = scanner.number<std::uint64_t>();
+    scanner.consume('\n');
+    return range;
+}
+
+constexpr Puzzle parse(std::string_view text) {
+    Puzzle puzzle;
+    aoc::Scanner scanner{text};
+    while (!scanner.done() && !scanner.consume('\n')) {
+        puzzle.ranges.push_back(parse_range(scanner));
+    }
+    while (!scanner.done()) {
+        puzzle.ids.push_back(scanner.number<std::uint64_t>());
+        scanner.consume('\n');
+    }
+    return puzzle;
+}
+
+#ifdef AOC_EMBED_INPUT
+#define AOC_EMBED_FILE "../day5/puzzle.txt"
+#define AOC_EMBED_XXD "../day5/puzzle.txt.inc"
+#include "../common/embed.h"
+
+constexpr auto answers = [] {
+    auto [ranges, ids] = parse(aoc::embedded_input);
+    return std::pair{part1(ranges, ids), part2(ranges)};
+}();
+
+int main() {
+    std::cout << answers.first << std::endl;
+    std::cout << answers.second << std::endl;
+    return 0;
+}
+#else
+int main() {
+    constexpr uint32_t schema = 1;
+    auto [input, snapshot] = aoc::open_or_stream("puzzle.txt", schema);
+    if (!input) {
+        std::cerr << "Error opening file" << std::endl;
+        return 1;
+    }
+    if (snapshot) {
+        auto ranges = snapshot->section<Range>(0);
+        auto ids = snapshot->section<std::uint64_t>(1);
+        int answer1 = 0;
+        uint64_t answer2 = 0;
+        {
+            aoc::Phase phase{"part1"};
+            answer1 = part1(ranges, ids);
+        }
+        {
+            aoc::Phase phase{"part2"};
+            answer2 = part2(ranges);
+        }
+        std::cout << answer1 << std::endl;
+        std::cout << answer2 << std::endl;
+        return 0;
+    }
+
+    aoc::Hasher hasher{std::filesystem::file_size("puzzle.txt")};
+    Puzzle parsed;
+    for (std::string line; std::getline(input, line);) {
+        hasher.update(line);
+        if (!input.eof()) {
+            hasher.update("\n");
+        }
         if (line.empty()) {
             break;
         }
-        size_t pos = line.find("-");
-        Range range{};
-        range.start = stoull(line.substr(0, pos));
-        range.end = stoull(line.substr(pos + 1));
-        ranges.push_back(range);
+        aoc::Scanner scanner{line};
+        parsed.ranges.push_back(parse_range(scanner));
+    }
+    uint64_t answer2 = 0;
+    {
+        aoc::Phase phase{"part2"};
+        answer2 = part2(parsed.ranges);
     }
-    while (getline(input, line)) {
-        ids.push_back(stoull(line));
+    int answer1 = 0;
+    {
+        aoc::Phase phase{"part1"};
+        const std::vector<Range> packed = pack(parsed.ranges);
+        answer1 = aoc::pipeline(
+            input, 0,
+            [&](std::string_view block) {
+                hasher.update(block);
+                auto ids = aoc::numbers<std::uint64_t>(block, '\n');
+                parsed.ids.insert(parsed.ids.end(), ids.begin(), ids.end());
+                return ids;
+            },
+            [&](std::vector<std::uint64_t> const& ids) { return count_fresh(packed, ids); },
+            [](int total, int block) { return total + block; });
     }
+    aoc::SnapshotWriter writer;
+    writer.add<Range>(parsed.ranges);
+    writer.add<std::uint64_t>(parsed.ids);
+    writer.write("puzzle.txt.snapshot", schema, hasher.finish());
 
-    std::cout << part1(ranges, ids) << std::endl;
-    std::cout << part2(ranges) << std::endl;
+    std::cout << answer1 << std::endl;
+    std::cout << answer2 << std::endl;
 
     return 0;
 }
+#endif
@@ -1,25 +1,31 @@
 #include <fstream>
 #include <iostream>
+#include <memory_resource>
 #include <numeric>
 #include <string>
 #include <vector>
 
-using Matrix = std::vector<std::vector<size_t>>;
+#include "../common/memory.h"
+#include "../common/parse.h"
+
+using Matrix = std::pmr::vector<std::pmr::vector<size_t>>;
 
 Matrix transpose(const Matrix& matrix) {
-    Matrix result;
+    Matrix result{matrix.get_allocator()};
+    result.reserve(matrix[0].size());
     for (size_t i = 0; i < matrix[0].size(); ++i) {
-        std::vector<size_t> row;
+        auto& row = result.emplace_back();
+        row.reserve(matrix.size());
         for (size_t j = 0; j < matrix.size(); ++j) {
             row.push_back(matrix[j][i]);
         }
-        result.push_back(row);
     }
     return result;
 }
 
-std::vector<size_t> get_positions(std::string_view symbol_line) {
-    std::vector<size_t> positions;
+std::pmr::vector<size_t> get_positions(std::string_view symbol_line,
+                                       std::pmr::memory_resource* resource) {
+    std::pmr::vector<size_t> positions{resource};
     for (size_t i = 0; i < symbol_line.size(); ++i) {
         if (symbol_line[i] != ' ') {
             positions.push_back(i);
@@ -30,7 +36,7 @@ std::vector<size_t> get_positions(std::string_view symbol_line) {
 }
 
 size_t get_total(std::string_view symbol_line, const Matrix& matrix) {
-    std::vector<size_t> positions = get_positions(symbol_line);
+    auto positions = get_positions(symbol_line, matrix.get_allocator().resource());
     size_t total{0};
     for (size_t i = 0; i < positions.size() - 1; ++i) {
         char symbol = symbol_line[positions[i]];
@@ -44,44 +50,49 @@ size_t get_total(std::string_view symbol_line, const Matrix& matrix) {
     return total;
 }
 
-size_t part1(std::string_view symbol_line, const std::vector<std::string>& lines) {
-    std::vector<size_t> positions = get_positions(symbol_line);
+size_t part1(std::string_view symbol_line, const std::vector<std::string>& lines,
+             std::pmr::memory_resource* resource) {
+    auto positions = get_positions(symbol_line, resource);
 
-    Matrix matrix;
+    Matrix matrix{resource};
+    matrix.reserve(lines.size());
     for (auto& line : lines) {
-        std::vector<size_t> row;
+        auto& row = matrix.emplace_back();
+        row.reserve(positions.size() - 1);
         for (size_t i = 0; i < positions.size() - 1; ++i) {
-            row.push_back(stoull(line.substr(positions[i], positions[i + 1])));
+            aoc::Scanner scanner{std::string_view{line}.substr(positions[i])};
+            scanner.skip(' ');
+            row.push_back(scanner.number<size_t>());
         }
-        matrix.push_back(row);
     }
     Matrix transposed = transpose(matrix);
     return get_total(symbol_line, transposed);
 }
 
-size_t part2(std::string_view symbol_line, const std::vector<std::string>& lines) {
+size_t part2(std::string_view symbol_line, const std::vector<std::string>& lines,
+             std::pmr::memory_resource* resource) {
     size_t line_len{lines[0].size()};
 
     size_t index{0};
-    Matrix matrix;
-    std::vector<size_t> numbers;
+    Matrix matrix{resource};
+    std::pmr::vector<size_t> numbers{resource};
     for (index = 0; index < line_len; ++index) {
-        std::vector<char> chars;
+        bool found{false};
+        size_t number{0};
         for (auto& line : lines) {
             if (line.at(index) != ' ') {
-                chars.push_back(line[index]);
+                number = number * 10 + (line[index] - '0');
+                found = true;
             }
         }
-        if (!chars.empty()) {
-            std::string s(chars.begin(), chars.end());
-            size_t number = stoull(s);
+        if (found) {
             numbers.push_back(number);
         } else {
-            matrix.push_back(numbers);
-            numbers.clear();
+            matrix.push_back(std::move(numbers));
+            numbers = std::pmr::vector<size_t>{resource};
         }
     }
-    matrix.push_back(numbers);
+    matrix.push_back(std::move(numbers));
     return get_total(symbol_line, matrix);
 }
 
@@ -99,7 +110,18 @@ int main() {
     std::string symbol_line = lines.back();
     lines.pop_back();
 
-    std::cout << "part1: " << part1(symbol_line, lines) << std::endl;
-    std::cout << "part2: " << part2(symbol_line, lines) << std::endl;
+    aoc::Arena arena;
+    size_t answer1 = 0;
+    size_t answer2 = 0;
+    {
+        aoc::Phase phase{"part1", arena};
+        answer1 = part1(symbol_line, lines, arena.resource());
+    }
+    {
+        aoc::Phase phase{"part2", arena};
+        answer2 = part2(symbol_line, lines, arena.resource());
+    }
+    std::cout << "part1: " << answer1 << std::endl;
+    std::cout << "part2: " << answer2 << std::endl;
     return 0;
 }
@@ -1,16 +1,37 @@
+#include <array>
 #include <fstream>
 #include <iostream>
 #include <numeric>
 #include <print>
+#include <span>
 #include <string>
+#include <string_view>
+#include <type_traits>
 #include <vector>
 
+#include "../common/memory.h"
+#include "../common/parse.h"
+
 using namespace std;
 
-int part1(const vector<string>& lines) {
+// One slot per column, in a fixed-size array when the width is known at compile time.
+template <typename T, size_t Width>
+using Beams = conditional_t<Width == dynamic_extent, vector<T>, array<T, Width>>;
+
+template <typename T, size_t Width>
+constexpr Beams<T, Width> make_beams(size_t width) {
+    if constexpr (Width == dynamic_extent) {
+        return Beams<T, Width>(width, T{});
+    } else {
+        return Beams<T, Width>{};
+    }
+}
+
+template <size_t Width = dynamic_extent>
+constexpr int part1(span<const string_view> lines) {
     size_t width = lines.front().size();
     size_t midpoint = width / 2;
-    vector<bool> visited(width, false);
+    auto visited = make_beams<bool, Width>(width);
     visited[midpoint] = true;
 
     int num_splits{0};
@@ -27,10 +48,11 @@ int part1(const vector<string>& lines) {
     return num_splits;
 }
 
-uint64_t part2(const vector<string>& lines) {
+template <size_t Width = dynamic_extent>
+constexpr uint64_t part2(span<const string_view> lines) {
     size_t width = lines.front().size();
     size_t midpoint = width / 2;
-    vector<uint64_t> visited(width, 0);
+    auto visited = make_beams<uint64_t, Width>(width);
     visited[midpoint] = 1;
 
     for (auto& line : lines) {
@@ -45,19 +67,55 @@ uint64_t part2(const vector<string>& lines) {
     return accumulate(visited.begin(), visited.end(), 0ull);
 }
 
+constexpr vector<string_view> parse(string_view text) {
+    vector<string_view> lines;
+    for (aoc::Scanner scanner{text}; !scanner.done();) {
+        lines.push_back(scanner.line());
+    }
+    return lines;
+}
+
+#ifdef AOC_EMBED_INPUT
+#define AOC_EMBED_FILE "../day7/puzzle.txt"
+#define AOC_EMBED_XXD "../day7/puzzle.txt.inc"
+#include "../common/embed.h"
+
+constexpr size_t puzzle_width = parse(aoc::embedded_input).front().size();
+
+// The sweeps are specialised on the embedded input's width.
+constexpr auto answers = [] {
+    const auto lines = parse(aoc::embedded_input);
+    return pair{part1<puzzle_width>(lines), part2<puzzle_width>(lines)};
+}();
+
+int main() {
+    println("Part 1: {}", answers.first);
+    println("Part 2: {}", answers.second);
+    return 0;
+}
+#else
 int main() {
     ifstream file("puzzle.txt");
     if (!file) {
         std::cerr << "Error opening file" << std::endl;
         return 1;
     }
-    string line;
-    vector<string> lines;
-    while (getline(file, line)) {
-        lines.push_back(line);
-    }
+    const string text = aoc::read_all(file);
     file.close();
-    println("Part 1: {}", part1(lines));
-    println("Part 2: {}", part2(lines));
+    // No snapshot: the grid is views of the input's own lines, so there is no parsing to skip.
+    const auto lines = parse(text);
+    int answer1 = 0;
+    uint64_t answer2 = 0;
+    {
+        aoc::Phase phase{"part1"};
+        answer1 = part1(lines);
+    }
+    {
+        aoc::Phase phase{"part2"};
+        answer2 = part2(lines);
+    }
+    println("Part 1: {}", answer1);
+    println("Part 2: {}", answer2);
     return 0;
 }
+#endif
@@ -1,77 +1,253 @@
 #include <algorithm>
+#include <array>
+#include <barrier>
 #include <cstdint>
 #include <fstream>
 #include <iostream>
+#include <limits>
+#include <memory_resource>
 #include <ranges>
 #include <span>
+#include <stdexcept>
 #include <string>
 #include <string_view>
+#include <thread>
+#include <utility>
 #include <vector>
 
+#include "../common/memory.h"
+#include "../common/parse.h"
+#include "../common/snapshot.h"
+
 using namespace std;
 
-struct JBox;
-using Circuit = std::vector<JBox>;
-using Connection = std::tuple<uint64_t, JBox, JBox>;
+using Circuit = std::pmr::vector<uint32_t>;
+using Circuits = std::pmr::vector<Circuit>;
+
+// A pair of boxes by input index, with its exact squared distance.
+struct Connection {
+    uint64_t distance;
+    uint32_t from;
+    uint32_t to;
+};
+
+// Box coordinates as columns padded to a multiple of `lanes`. Doubles hold the squared
+// distances exactly for coordinates below 2^25.
+struct Points {
+    static constexpr size_t lanes = 8;
+    static constexpr uint64_t max_coordinate = uint64_t{1} << 25;
 
-struct JBox {
-    JBox() = default;
-    JBox(std::vector<int> const& v) : x(v[0]), y(v[1]), z(v[2]) {}
+    static size_t padded(size_t n) { return (n + lanes - 1) / lanes * lanes; }
 
-    uint64_t distance(JBox const& other) {
-        const auto dx = x - other.x;
-        const auto dy = y - other.y;
-        const auto dz = z - other.z;
-        return static_cast<uint64_t>(sqrt(dx * dx + dy * dy + dz * dz));
+    double distance(size_t a, size_t b) const {
+        const double dx = x[a] - x[b];
+        const double dy = y[a] - y[b];
+        const double dz = z[a] - z[b];
+        return dx * dx + dy * dy + dz * dz;
     }
 
-    vector<tuple<uint64_t, JBox>> get_distances(std::vector<JBox> const& points) {
-        vector<tuple<uint64_t, JBox>> distances{};
-        ranges::transform(points, std::back_inserter(distances),
-                          [&](JBox const& p) -> std::tuple<uint64_t, JBox> {
-                              return make_tuple(this->distance(p), p);
-                          });
-        return distances;
+    size_t x_product(size_t a, size_t b) const {
+        return static_cast<size_t>(x[a]) * static_cast<size_t>(x[b]);
     }
 
-    bool operator==(JBox other) { return x == other.x && y == other.y && z == other.z; }
+    size_t size = 0;
+    span<double const> x;
+    span<double const> y;
+    span<double const> z;
+};
+
+struct Columns {
+    explicit Columns(pmr::memory_resource* resource) : x(resource), y(resource), z(resource) {}
 
-    uint64_t x;
-    uint64_t y;
-    uint64_t z;
+    Points view() const { return {size, x, y, z}; }
+
+    size_t size = 0;
+    pmr::vector<double> x;
+    pmr::vector<double> y;
+    pmr::vector<double> z;
 };
 
-template <>
-struct std::formatter<JBox> {
-    constexpr auto parse(format_parse_context& ctx) { return ctx.begin(); }
+Columns parse(string_view text, pmr::memory_resource* resource) {
+    Columns columns{resource};
+    for (aoc::Scanner scanner{text}; !scanner.done(); scanner.consume('\n')) {
+        const uint64_t x = scanner.number<uint64_t>();
+        scanner.expect(',');
+        const uint64_t y = scanner.number<uint64_t>();
+        scanner.expect(',');
+        const uint64_t z = scanner.number<uint64_t>();
+        if (max({x, y, z}) >= Points::max_coordinate) {
+            throw runtime_error("junction box coordinate too large");
+        }
+        columns.x.push_back(static_cast<double>(x));
+        columns.y.push_back(static_cast<double>(y));
+        columns.z.push_back(static_cast<double>(z));
+    }
+    columns.size = columns.x.size();
+    for (auto* column : {&columns.x, &columns.y, &columns.z}) {
+        column->resize(Points::padded(columns.size), 0.0);
+    }
+    return columns;
+}
 
-    auto format(JBox const& p, format_context& ctx) const {
-        return std::format_to(ctx.out(), "[{} {} {}]", p.x, p.y, p.z);
+// Snapshot schema 2: the padded x, y and z columns in sections 0-2, the box count in section 3.
+void save(aoc::SnapshotWriter& writer, Columns const& columns) {
+    const uint64_t count = columns.size;
+    writer.add<double>(columns.x);
+    writer.add<double>(columns.y);
+    writer.add<double>(columns.z);
+    writer.add<uint64_t>({&count, 1});
+}
+
+Points map_points(aoc::Snapshot const& snapshot) {
+    auto count = snapshot.section<uint64_t>(3);
+    if (count.size() != 1) {
+        throw runtime_error("snapshot has no box count");
     }
-};
+    Points points{static_cast<size_t>(count[0]), snapshot.section<double>(0),
+                  snapshot.section<double>(1), snapshot.section<double>(2)};
+    const size_t padded = Points::padded(points.size);
+    if (points.x.size() != padded || points.y.size() != padded || points.z.size() != padded) {
+        throw runtime_error("snapshot columns do not match the box count");
+    }
+    return points;
+}
+
+// Runs task(id, lo, hi) over num_threads contiguous slices of [0, n), the first on this thread.
+template <typename Task>
+void for_each_slice(size_t n, size_t num_threads, Task&& task) {
+    const size_t chunk = (n + num_threads - 1) / num_threads;
+    vector<jthread> threads;
+    for (size_t id = 1; id < num_threads; ++id) {
+        threads.emplace_back([&, id] { task(id, min(n, id * chunk), min(n, (id + 1) * chunk)); });
+    }
+    task(0, 0, min(n, chunk));
+}
+
+// Stable parallel LSD radix sort on the squared distance, one byte per pass.
+void radix_sort(pmr::vector<Connection>& connections) {
+    const size_t n = connections.size();
+    if (n < 2) {
+        return;
+    }
+    constexpr size_t min_slice = 1 << 16;
+    const size_t num_threads =
+        clamp<size_t>(thread::hardware_concurrency(), 1, max<size_t>(1, n / min_slice));
+    const uint64_t max_key = ranges::max(connections, {}, &Connection::distance).distance;
 
-vector<Connection> find_connections(vector<JBox> positions) {
-    vector<Connection> connections{};
-    while (!positions.empty()) {
-        JBox position = positions.back();
-        positions.pop_back();
+    pmr::vector<Connection> buffer(n, connections.get_allocator());
+    pmr::vector<array<size_t, 256>> offsets(num_threads, connections.get_allocator());
+    for (unsigned shift = 0; shift < 64 && (max_key >> shift) != 0; shift += 8) {
+        for_each_slice(n, num_threads, [&](size_t id, size_t lo, size_t hi) {
+            auto& count = offsets[id];
+            count.fill(0);
+            for (size_t i = lo; i < hi; ++i) {
+                ++count[(connections[i].distance >> shift) & 0xff];
+            }
+        });
+
+        size_t total = 0;
+        for (size_t digit = 0; digit < 256; ++digit) {
+            for (auto& count : offsets) {
+                total += exchange(count[digit], total);
+            }
+        }
 
-        auto distances = position.get_distances(positions);
-        ranges::for_each(distances, [&](auto&& distance) {
-            auto [min_distance, min_position] = distance;
-            connections.push_back({min_distance, min_position, position});
+        for_each_slice(n, num_threads, [&](size_t id, size_t lo, size_t hi) {
+            auto& next = offsets[id];
+            for (size_t i = lo; i < hi; ++i) {
+                buffer[next[(connections[i].distance >> shift) & 0xff]++] = connections[i];
+            }
         });
+        connections.swap(buffer);
     }
+}
 
-    sort(connections.begin(), connections.end(),
-         [](auto&& a, auto&& b) { return std::get<0>(a) < std::get<0>(b); });
-    return connections;
+// Keeps the k shortest of `kept` in order, earlier ones winning ties; returns the longest kept.
+uint64_t keep_shortest(pmr::vector<Connection>& kept, size_t k, pmr::vector<uint64_t>& scratch) {
+    scratch.clear();
+    for (auto const& connection : kept) {
+        scratch.push_back(connection.distance);
+    }
+    ranges::nth_element(scratch, scratch.begin() + static_cast<ptrdiff_t>(k - 1));
+    const uint64_t limit = scratch[k - 1];
+    size_t ties = k - static_cast<size_t>(ranges::count_if(
+                          kept, [&](Connection const& c) { return c.distance < limit; }));
+    erase_if(kept, [&](Connection const& c) {
+        if (c.distance != limit) {
+            return c.distance > limit;
+        }
+        if (ties == 0) {
+            return true;
+        }
+        --ties;
+        return false;
+    });
+    return limit;
 }
 
-optional<int> get_position(vector<Circuit>& circuits, JBox jbox) {
-    auto it = ranges::find_if(circuits, [&](Circuit& circuit) {
-        return ranges::find_if(circuit, [&](auto value) { return value == jbox; }) != circuit.end();
+// The `count` shortest pairs in stable sorted order, in O(n + threads * count) memory.
+pmr::vector<Connection> closest_connections(Points const& points,
+                                            size_t count,
+                                            pmr::memory_resource* resource) {
+    const size_t n = points.size;
+    const size_t total = n < 2 ? 0 : n * (n - 1) / 2;
+    count = min(count, total);
+    if (count == 0) {
+        return pmr::vector<Connection>{resource};
+    }
+    constexpr size_t min_slice = 1 << 16;
+    const size_t num_threads =
+        clamp<size_t>(thread::hardware_concurrency(), 1, max<size_t>(1, total / min_slice));
+
+    // Rows split so every thread gets about as many pairs.
+    pmr::vector<size_t> first_row(num_threads + 1, n, resource);
+    first_row[0] = 0;
+    for (size_t i = 0, pairs = 0, slice = 1; i < n && slice < num_threads; ++i) {
+        pairs += n - 1 - i;
+        if (pairs * num_threads >= total * slice) {
+            first_row[slice++] = i + 1;
+        }
+    }
+
+    // The arena is single-threaded: every buffer is sized before the threads start.
+    pmr::vector<pmr::vector<Connection>> kept(num_threads, resource);
+    pmr::vector<pmr::vector<uint64_t>> scratches(num_threads, resource);
+    for (size_t id = 0; id < num_threads; ++id) {
+        kept[id].reserve(2 * count);
+        scratches[id].reserve(2 * count);
+    }
+    for_each_slice(num_threads, num_threads, [&](size_t id, size_t, size_t) {
+        auto& mine = kept[id];
+        auto& scratch = scratches[id];
+        // Later pairs lose ties, so only strictly shorter ones get in.
+        uint64_t limit = numeric_limits<uint64_t>::max();
+        for (auto i = static_cast<uint32_t>(first_row[id]); i < first_row[id + 1]; ++i) {
+            for (uint32_t j = i + 1; j < n; ++j) {
+                const auto distance = static_cast<uint64_t>(points.distance(i, j));
+                if (distance < limit) {
+                    mine.push_back({distance, i, j});
+                    if (mine.size() == 2 * count) {
+                        limit = keep_shortest(mine, count, scratch);
+                    }
+                }
+            }
+        }
     });
+
+    pmr::vector<Connection> connections{resource};
+    for (auto const& mine : kept) {
+        connections.insert(connections.end(), mine.begin(), mine.end());
+    }
+    if (connections.size() > count) {
+        keep_shortest(connections, count, scratches[0]);
+    }
+    radix_sort(connections);
+    return connections;
+}
+
+optional<int> get_position(Circuits& circuits, uint32_t jbox) {
+    auto it = ranges::find_if(
+        circuits, [&](Circuit& circuit) { return ranges::find(circuit, jbox) != circuit.end(); });
     if (it != circuits.end()) {
         return it - circuits.begin();
     } else {
@@ -79,12 +255,12 @@ optional<int> get_position(vector<Circuit>& circuits, JBox jbox) {
     }
 }
 
-void search_circuits(vector<Circuit>& circuits, Connection& connection) {
+void search_circuits(Circuits& circuits, Connection const& connection) {
     auto [ignore, jbox1, jbox2] = connection;
     auto jbox1_position = get_position(circuits, jbox1);
     auto jbox2_position = get_position(circuits, jbox2);
     if (!jbox1_position.has_value() && !jbox2_position.has_value()) {
-        circuits.push_back({jbox1, jbox2});
+        circuits.emplace_back(initializer_list<uint32_t>{jbox1, jbox2});
     } else
         // One match found, add the other
         if (jbox1_position.has_value() && !jbox2_position.has_value()) {
@@ -103,11 +279,10 @@ void search_circuits(vector<Circuit>& circuits, Connection& connection) {
             }
 }
 
-size_t part1(vector<JBox> positions, size_t num_pairs) {
-    vector<Circuit> circuits{};
-    auto found = find_connections(positions);
-    span<Connection> connection{found};
-    auto connections = connection.subspan(0, num_pairs);
+size_t part1(Points const& points, size_t num_pairs, pmr::memory_resource* resource) {
+    Circuits circuits{resource};
+    auto found = closest_connections(points, num_pairs, resource);
+    span<Connection> connections{found};
 
     while (!connections.empty()) {
         auto connection = connections.front();
@@ -115,7 +290,7 @@ size_t part1(vector<JBox> positions, size_t num_pairs) {
         search_circuits(circuits, connection);
     }
 
-    vector<size_t> lengths{};
+    pmr::vector<size_t> lengths{resource};
     for (auto& circuit : circuits) {
         lengths.push_back(circuit.size());
     }
@@ -124,47 +299,182 @@ size_t part1(vector<JBox> positions, size_t num_pairs) {
     return ranges::fold_left(top_three, 1, [](auto acc, auto length) { return acc * length; });
 }
 
-size_t max_length(vector<Circuit>& circuits) {
+size_t max_length(Circuits& circuits) {
     auto largest =
         ranges::max_element(circuits, [](Circuit& a, Circuit& b) { return a.size() < b.size(); });
     return largest->size();
 }
 
-size_t part2(vector<JBox>& positions) {
-    vector<Circuit> circuits{};
-    auto found = find_connections(positions);
-    span<Connection> connections{found};
-    while (connections.size() > 0) {
-        auto connection = connections.front();
-        connections = connections.subspan(1);
+// Reference answer for part2, Kruskal over every pair.
+size_t part2_kruskal(Points const& points, pmr::memory_resource* resource) {
+    Circuits circuits{resource};
+    const size_t n = points.size;
+    auto found = closest_connections(points, n * (n - 1) / 2, resource);
+    for (auto const& connection : found) {
         search_circuits(circuits, connection);
-        if (max_length(circuits) == positions.size()) {
-            auto [ignore, jbox1, jbox2] = connection;
-            return jbox1.x * jbox2.x;
+        if (max_length(circuits) == n) {
+            return points.x_product(connection.from, connection.to);
         }
     }
     return 0;
 }
 
+// dist = min(dist, distance to u + blocked) over whole blocks of lanes, which gcc vectorizes
+// at -O2. `blocked` is infinity for tree vertices and padding, 0 otherwise.
+void relax(double const* xs,
+           double const* ys,
+           double const* zs,
+           double const* blocked,
+           double* __restrict dist,
+           double ux,
+           double uy,
+           double uz,
+           size_t blocks) {
+    for (size_t v = 0; v < blocks * Points::lanes; ++v) {
+        const double dx = xs[v] - ux;
+        const double dy = ys[v] - uy;
+        const double dz = zs[v] - uz;
+        const double d = dx * dx + dy * dy + dz * dz + blocked[v];
+        dist[v] = d < dist[v] ? d : dist[v];
+    }
+}
+
+// Prim over the implicit complete graph; the answer is the spanning tree's heaviest edge.
+size_t part2_dense(Points const& points, pmr::memory_resource* resource) {
+    constexpr double unreached = numeric_limits<double>::infinity();
+    const size_t n = points.size;
+    if (n < 2) {
+        return 0;
+    }
+    const size_t padded = Points::padded(n);
+
+    pmr::vector<double> best(padded, unreached, resource);  // squared distance to the tree
+    pmr::vector<double> blocked(padded, unreached, resource);
+    fill_n(blocked.begin(), n, 0.0);
+    pmr::vector<uint32_t> order(resource);  // vertices in the order they joined the tree
+    order.reserve(n);
+
+    struct Candidate {
+        double distance = unreached;
+        uint32_t index = 0;
+    };
+
+    // Every round ends at a barrier, so each thread needs enough vertices to relax.
+    constexpr size_t min_slice = 1 << 12;
+    const size_t num_threads =
+        clamp<size_t>(thread::hardware_concurrency(), 1, max<size_t>(1, n / min_slice));
+    const size_t chunk = Points::padded((padded + num_threads - 1) / num_threads);
+    pmr::vector<Candidate> candidates(num_threads, resource);
+
+    uint32_t current = 0;
+    best[current] = unreached;
+    blocked[current] = unreached;
+    order.push_back(current);
+    size_t remaining = n - 1;
+    double longest = -1;
+    uint32_t farthest = 0;
+
+    // Runs once per round, after every worker has relaxed its slice against `current`.
+    auto on_round_complete = [&]() noexcept {
+        auto next = ranges::min(candidates, {}, &Candidate::distance);
+        if (next.distance > longest) {
+            longest = next.distance;
+            farthest = next.index;
+        }
+        current = next.index;
+        best[current] = unreached;
+        blocked[current] = unreached;
+        order.push_back(current);
+        --remaining;
+    };
+    barrier sync(static_cast<ptrdiff_t>(num_threads), on_round_complete);
+
+    auto worker = [&](size_t id) {
+        const size_t lo = min(padded, id * chunk);
+        const size_t hi = min(padded, lo + chunk);
+        double* dist = best.data();
+
+        while (remaining > 0) {
+            const uint32_t u = current;
+            relax(points.x.data() + lo, points.y.data() + lo, points.z.data() + lo,
+                  blocked.data() + lo, dist + lo, points.x[u], points.y[u], points.z[u],
+                  (hi - lo) / Points::lanes);
+
+            Candidate local{};
+            for (size_t v = lo; v < hi; ++v) {
+                if (dist[v] < local.distance) {
+                    local = {dist[v], static_cast<uint32_t>(v)};
+                }
+            }
+            candidates[id] = local;
+            sync.arrive_and_wait();
+        }
+    };
+
+    {
+        vector<jthread> threads;
+        for (size_t id = 1; id < num_threads; ++id) {
+            threads.emplace_back(worker, id);
+        }
+        worker(0);
+    }
+
+    // Its parent is the earliest tree vertex at that distance.
+    const auto joined = ranges::find(order, farthest);
+    const auto parent = *ranges::find_if(order.begin(), joined, [&](uint32_t u) {
+        return points.distance(u, farthest) == longest;
+    });
+    return points.x_product(parent, farthest);
+}
+
 int main() {
     std::ifstream file("puzzle.txt");
     if (!file) {
         std::cerr << "Error opening file" << std::endl;
         return 1;
     }
-    std::string line;
-    std::vector<JBox> positions;
-    while (std::getline(file, line)) {
-        auto myVector = std::vector<int>(
-            std::from_range, line | std::views::split(',') | std::views::transform([](auto&& s) {
-                                 return stoi(std::string(begin(s), end(s)));
-                             }));
-        positions.emplace_back(myVector);
-    }
+    aoc::Arena arena;
+    const std::string text = aoc::read_all(file);
     file.close();
 
+    constexpr uint32_t schema = 2;
+    const uint64_t hash = aoc::hash_bytes(text);
+    auto snapshot = aoc::Snapshot::open("puzzle.txt.snapshot", schema, hash);
+    Columns parsed{arena.resource()};
+    auto load = [&] {
+        if (snapshot) {
+            try {
+                return map_points(*snapshot);
+            } catch (std::runtime_error const&) {
+                // Rebuilt and rewritten below.
+            }
+        }
+        parsed = parse(text, arena.resource());
+        aoc::SnapshotWriter writer;
+        save(writer, parsed);
+        writer.write("puzzle.txt.snapshot", schema, hash);
+        return parsed.view();
+    };
+    const Points points = load();
+
     size_t num_pairs = 1000;
-    println("{}", part1(positions, num_pairs));
-    println("{}", part2(positions));
+    size_t answer1 = 0;
+    size_t answer2 = 0;
+    {
+        aoc::Phase phase{"part1", arena};
+        answer1 = part1(points, num_pairs, arena.resource());
+    }
+    {
+        aoc::Phase phase{"part2", arena};
+        answer2 = part2_dense(points, arena.resource());
+    }
+#ifdef AOC_SELF_TEST
+    if (answer2 != part2_kruskal(points, arena.resource())) {
+        cerr << "part2 disagrees with Kruskal over every pair" << endl;
+        return 1;
+    }
+#endif
+    println("{}", answer1);
+    println("{}", answer2);
     return 0;
 }
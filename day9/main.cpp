@@ -1,11 +1,19 @@
 #include <algorithm>
+#include <atomic>
 #include <fstream>
 #include <iostream>
+#include <limits>
 #include <numeric>
 #include <ranges>
-#include <unordered_set>
+#include <span>
+#include <stdexcept>
+#include <thread>
 #include <vector>
 
+#include "../common/memory.h"
+#include "../common/parse.h"
+#include "../common/snapshot.h"
+
 using namespace std;
 
 struct Point {
@@ -20,7 +28,23 @@ struct Point {
     }
 };
 
-vector<pair<Point, Point>> combinations(vector<Point> const& points) {
+// The red tiles as x and y columns, which is how the snapshot stores them.
+struct Points {
+    span<uint64_t const> x;
+    span<uint64_t const> y;
+
+    size_t size() const { return x.size(); }
+
+    Point operator[](size_t i) const { return {x[i], y[i]}; }
+
+    auto all() const {
+        return views::iota(size_t{0}, size()) | views::transform([this](size_t i) {
+                   return (*this)[i];
+               });
+    }
+};
+
+vector<pair<Point, Point>> combinations(Points const& points) {
     vector<pair<Point, Point>> result;
     for (int i = 0; i < points.size() - 1; i++) {
         for (int j = i + 1; j < points.size(); j++) {
@@ -30,89 +54,168 @@ vector<pair<Point, Point>> combinations(vector<Point> const& points) {
     return result;
 }
 
-enum class Axis { Vertical, Horizontal };
-
-struct Edge {
-    uint64_t along;
-    uint64_t start;
-    uint64_t end;
+// Largest area over the pairs `valid` accepts, taking rows by descending area bound until no
+// row can beat the best.
+template <typename Valid>
+uint64_t largest_area(Points const& points, Valid const& valid) {
+    if (points.size() < 2) {
+        return 0;
+    }
+    auto [min_x, max_x] = ranges::minmax(points.x);
+    auto [min_y, max_y] = ranges::minmax(points.y);
+    auto bound = [&](Point const& p) {
+        return (max(p.x - min_x, max_x - p.x) + 1) * (max(p.y - min_y, max_y - p.y) + 1);
+    };
 
-    bool operator==(Edge const& other) const {
-        return along == other.along && start == other.start && end == other.end;
+    vector<uint64_t> bounds(points.size());
+    vector<uint32_t> order(points.size());
+    for (uint32_t i = 0; i < points.size(); i++) {
+        bounds[i] = bound(points[i]);
+        order[i] = i;
     }
-};
+    ranges::sort(order, greater{}, [&](uint32_t i) { return bounds[i]; });
 
-class MyHashFunction {
-   public:
-    size_t operator()(const Edge& e) const { return (e.along * 100) ^ (e.start * 10) ^ e.end; }
-};
+    atomic<size_t> next_row{0};
+    atomic<uint64_t> best{0};
+    auto worker = [&] {
+        for (size_t row = next_row++; row < order.size(); row = next_row++) {
+            if (bounds[order[row]] <= best.load(memory_order_relaxed)) {
+                return;
+            }
+            const Point p1 = points[order[row]];
+            for (size_t other = row + 1; other < order.size(); other++) {
+                const Point p2 = points[order[other]];
+                uint64_t area = p1.area(p2);
+                uint64_t current = best.load(memory_order_relaxed);
+                if (area <= current || !valid(p1, p2)) {
+                    continue;
+                }
+                while (area > current && !best.compare_exchange_weak(current, area)) {
+                }
+            }
+        }
+    };
 
-using MySet = unordered_set<Edge, MyHashFunction>;
-
-MySet find_edges(vector<Point> const& points, Axis axis) {
-    return combinations(points) | views::filter([&axis](pair<Point, Point> const& pair) {
-               auto [p1, p2] = pair;
-               if (axis == Axis::Vertical) {
-                   return p1.x == p2.x;
-               } else {
-                   return p1.y == p2.y;
-               }
-           }) |
-           views::transform([&axis](pair<Point, Point> const& pair) {
-               auto [p1, p2] = pair;
-               if (axis == Axis::Vertical) {
-                   return Edge{p1.x, min(p1.y, p2.y), max(p1.y, p2.y)};
-               } else {
-                   return Edge{p1.y, min(p1.x, p2.x), max(p1.x, p2.x)};
-               }
-           }) |
-           ranges::to<MySet>();
+    {
+        vector<jthread> threads;
+        for (unsigned i = 1; i < thread::hardware_concurrency(); i++) {
+            threads.emplace_back(worker);
+        }
+        worker();
+    }
+    return best;
 }
 
+// Distinct tile coordinates along one axis in sorted order. Compressed index 2i stands for
+// values[i] and 2i + 1 for the run of tiles strictly between values[i] and values[i + 1].
+struct Compressed {
+    vector<uint64_t> values;
+
+    explicit Compressed(vector<uint64_t> coordinates) : values(std::move(coordinates)) {
+        ranges::sort(values);
+        values.erase(ranges::unique(values).begin(), values.end());
+    }
+
+    size_t index(uint64_t value) const {
+        return 2 * (ranges::lower_bound(values, value) - values.begin());
+    }
+
+    size_t size() const { return 2 * values.size() - 1; }
+
+    // Whether compressed index i is a run between two adjacent values, which holds no tiles.
+    bool empty(size_t i) const { return i % 2 == 1 && values[i / 2 + 1] - values[i / 2] == 1; }
+};
+
 struct Part2 {
-    vector<Point> points;
-    MySet vertical_edges;
-    MySet horizontal_edges;
-
-    Part2(vector<Point> const& points)
-        : points(std::move(points)),
-          vertical_edges(find_edges(points, Axis::Vertical)),
-          horizontal_edges(find_edges(points, Axis::Horizontal)) {}
-
-    bool area_contains_no_edges(Point const& p1, Point const& p2) {
-        auto [min_x, max_x] = minmax(p1.x, p2.x);
-        auto [min_y, max_y] = minmax(p1.y, p2.y);
-        for (auto const& edge : vertical_edges) {
-            if (min_x < edge.along && edge.along < max_x && edge.end > min_y &&
-                edge.start < max_y) {
-                return false;
+    Points points;
+    Compressed xs;
+    Compressed ys;
+    // Summed-area table of outside cells with a zero row and column in front; wraps mod 2^32.
+    vector<uint32_t> outside;
+
+    Part2(Points points)
+        : points(points),
+          xs(vector<uint64_t>(points.x.begin(), points.x.end())),
+          ys(vector<uint64_t>(points.y.begin(), points.y.end())) {
+        rasterize();
+    }
+
+    bool area_is_inside(Point const& p1, Point const& p2) const {
+        auto [x0, x1] = minmax({xs.index(p1.x), xs.index(p2.x)});
+        auto [y0, y1] = minmax({ys.index(p1.y), ys.index(p2.y)});
+        const size_t stride = xs.size() + 1;
+        const uint32_t count = outside[(y1 + 1) * stride + x1 + 1] - outside[y0 * stride + x1 + 1] -
+                               outside[(y1 + 1) * stride + x0] + outside[y0 * stride + x0];
+        return count == 0;
+    }
+
+    size_t footprint() const {
+        return (xs.values.capacity() + ys.values.capacity()) * sizeof(uint64_t) +
+               outside.capacity() * sizeof(uint32_t);
+    }
+
+    uint64_t solve() const {
+        return largest_area(points, [this](Point const& p1, Point const& p2) {
+            return area_is_inside(p1, p2);
+        });
+    }
+
+   private:
+    enum class Cell : uint8_t { Unknown, Boundary, Outside };
+
+    // Cells holding no tiles are never counted as outside.
+    void rasterize() {
+        const size_t width = xs.size() + 2;
+        const size_t height = ys.size() + 2;
+        vector<Cell> cells(width * height, Cell::Unknown);
+
+        for (size_t i = 0; i < points.size(); i++) {
+            const Point from = points[i];
+            const Point to = points[(i + 1) % points.size()];
+            auto [x0, x1] = minmax({xs.index(from.x), xs.index(to.x)});
+            auto [y0, y1] = minmax({ys.index(from.y), ys.index(to.y)});
+            for (size_t y = y0; y <= y1; y++) {
+                for (size_t x = x0; x <= x1; x++) {
+                    cells[(y + 1) * width + x + 1] = Cell::Boundary;
+                }
             }
         }
-        for (auto const& edge : horizontal_edges) {
-            if (min_y < edge.along && edge.along < max_y && edge.end > min_x &&
-                edge.start < max_x) {
-                return false;
+
+        vector<size_t> stack{0};
+        cells[0] = Cell::Outside;
+        while (!stack.empty()) {
+            const size_t cell = stack.back();
+            stack.pop_back();
+            const size_t x = cell % width;
+            const size_t y = cell / width;
+            auto visit = [&](size_t next) {
+                if (cells[next] == Cell::Unknown) {
+                    cells[next] = Cell::Outside;
+                    stack.push_back(next);
+                }
+            };
+            if (x > 0) visit(cell - 1);
+            if (x + 1 < width) visit(cell + 1);
+            if (y > 0) visit(cell - width);
+            if (y + 1 < height) visit(cell + width);
+        }
+
+        const size_t stride = xs.size() + 1;
+        outside.assign(stride * (ys.size() + 1), 0);
+        for (size_t y = 0; y < ys.size(); y++) {
+            for (size_t x = 0; x < xs.size(); x++) {
+                const uint32_t is_outside = cells[(y + 1) * width + x + 1] == Cell::Outside &&
+                                            !xs.empty(x) && !ys.empty(y);
+                outside[(y + 1) * stride + x + 1] = is_outside + outside[y * stride + x + 1] +
+                                                    outside[(y + 1) * stride + x] -
+                                                    outside[y * stride + x];
             }
         }
-        return true;
-    }
-
-    uint64_t solve() {
-        auto areas = combinations(points) | views::filter([&](pair<Point, Point> const& pair) {
-                         auto [p1, p2] = pair;
-                         return area_contains_no_edges(p1, p2);
-                     }) |
-                     views::transform([&](pair<Point, Point> const& points) {
-                         auto [p1, p2] = points;
-                         return p1.area(p2);
-                     }) |
-                     ranges::to<vector<uint64_t>>();
-        return ranges::fold_left(
-            areas, 0ull, [](uint64_t max_area, uint64_t area) { return max(max_area, area); });
     }
 };
 
-uint64_t part1(vector<Point> const& points) {
+// Reference answer for part1, checking every pair.
+uint64_t part1_brute(Points const& points) {
     auto combos = combinations(points);
     uint64_t max_area = transform_reduce(
         combos.begin(), combos.end(), 0ull,
@@ -125,20 +228,137 @@ uint64_t part1(vector<Point> const& points) {
     return max_area;
 }
 
+// Points with none below and to the left of them, by increasing x.
+vector<Point> lower_staircase(Points const& points) {
+    auto sorted = points.all() | ranges::to<vector<Point>>();
+    ranges::sort(sorted, {}, [](Point const& p) { return pair{p.x, p.y}; });
+    vector<Point> chain;
+    for (auto const& p : sorted) {
+        if (chain.empty() || p.y < chain.back().y) {
+            chain.push_back(p);
+        }
+    }
+    return chain;
+}
+
+// Points with none above and to the right of them, by increasing x.
+vector<Point> upper_staircase(Points const& points) {
+    auto sorted = points.all() | ranges::to<vector<Point>>();
+    ranges::sort(sorted, greater{}, [](Point const& p) { return pair{p.x, p.y}; });
+    vector<Point> chain;
+    for (auto const& p : sorted) {
+        if (chain.empty() || p.y > chain.back().y) {
+            chain.push_back(p);
+        }
+    }
+    ranges::reverse(chain);
+    return chain;
+}
+
+// Negative unless q is above and to the right of p.
+int64_t dominating_area(Point const& p, Point const& q) {
+    const int64_t dx = static_cast<int64_t>(q.x) - static_cast<int64_t>(p.x) + 1;
+    const int64_t dy = static_cast<int64_t>(q.y) - static_cast<int64_t>(p.y) + 1;
+    return dx <= 0 && dy <= 0 ? -dx * dy : dx * dy;
+}
+
+// The best upper partner never moves left as the lower corner moves right.
+int64_t best_dominating_area(vector<Point> const& lower,
+                             vector<Point> const& upper,
+                             size_t lo,
+                             size_t hi,
+                             size_t opt_lo,
+                             size_t opt_hi) {
+    if (lo >= hi) {
+        return 0;
+    }
+    const size_t mid = lo + (hi - lo) / 2;
+    int64_t best = numeric_limits<int64_t>::min();
+    size_t opt = opt_lo;
+    for (size_t j = opt_lo; j <= opt_hi; j++) {
+        if (int64_t area = dominating_area(lower[mid], upper[j]); area > best) {
+            best = area;
+            opt = j;
+        }
+    }
+    return max({best, best_dominating_area(lower, upper, lo, mid, opt_lo, opt),
+                best_dominating_area(lower, upper, mid + 1, hi, opt, opt_hi)});
+}
+
+// The largest rectangle joins two staircase points, with y as it is or mirrored.
+uint64_t part1(Points const& points) {
+    if (points.size() < 2) {
+        return 0;
+    }
+    const uint64_t max_y = ranges::max(points.y);
+    auto mirrored_y = points.y | views::transform([&](uint64_t y) { return max_y - y; }) |
+                      ranges::to<vector<uint64_t>>();
+
+    int64_t best = 0;
+    for (Points candidates : {points, Points{points.x, mirrored_y}}) {
+        auto lower = lower_staircase(candidates);
+        auto upper = upper_staircase(candidates);
+        best = max(best, best_dominating_area(lower, upper, 0, lower.size(), 0, upper.size() - 1));
+    }
+    return best;
+}
+
 int main() {
     ifstream file("puzzle.txt");
+    const string text = aoc::read_all(file);
 
-    vector<Point> points;
-    string line;
-    while (getline(file, line)) {
-        size_t pos = line.find(",");
-        int x = stoi(line.substr(0, pos));
-        int y = stoi(line.substr(pos + 1));
-        points.push_back(Point(x, y));
-    }
+    // Snapshot layout, schema 2: sections 0 and 1 are the x and y columns, used in place.
+    constexpr uint32_t schema = 2;
+    const uint64_t hash = aoc::hash_bytes(text);
+    auto snapshot = aoc::Snapshot::open("puzzle.txt.snapshot", schema, hash);
+    vector<uint64_t> parsed_x;
+    vector<uint64_t> parsed_y;
+    auto load = [&] {
+        if (snapshot) {
+            try {
+                Points mapped{snapshot->section<uint64_t>(0), snapshot->section<uint64_t>(1)};
+                if (mapped.x.size() == mapped.y.size()) {
+                    return mapped;
+                }
+            } catch (runtime_error const&) {
+                // Rebuilt and rewritten below.
+            }
+        }
+        for (aoc::Scanner scanner{text}; !scanner.done(); scanner.consume('\n')) {
+            parsed_x.push_back(scanner.number<uint64_t>());
+            scanner.expect(',');
+            parsed_y.push_back(scanner.number<uint64_t>());
+        }
+        aoc::SnapshotWriter writer;
+        writer.add<uint64_t>(parsed_x);
+        writer.add<uint64_t>(parsed_y);
+        writer.write("puzzle.txt.snapshot", schema, hash);
+        return Points{parsed_x, parsed_y};
+    };
+    const Points points = load();
 
-    println("{}", part1(points));
-    Part2 part2(points);
-    println("{}", part2.solve());
+    uint64_t max_area = 0;
+    {
+        aoc::Phase phase{"part1"};
+        max_area = part1(points);
+    }
+#ifdef AOC_SELF_TEST
+    if (max_area != part1_brute(points)) {
+        cerr << "part1 disagrees with the brute-force search" << endl;
+        return 1;
+    }
+#endif
+    println("{}", max_area);
+    uint64_t answer2 = 0;
+    {
+        aoc::Phase phase{"part2"};
+        Part2 part2(points);
+        if (points.size() > 10000) {
+            cerr << format("part2 grid: {} vertices, {} bytes", points.size(), part2.footprint())
+                 << endl;
+        }
+        answer2 = part2.solve();
+    }
+    println("{}", answer2);
     return 0;
 }